@@ -0,0 +1,298 @@
+/**
+ * @file affinity.cpp
+ * thread-to-core placement based on the topology in /sys/devices/system/cpu
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>	//std::sort
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>		//sysconf
+#include "affinity.h"
+
+using namespace std;
+
+
+const char* placement_name[] = {"Compact", "Scatter", "Physical", "SMT-pairs", "List"};
+
+static const char SYSCPU[] = "/sys/devices/system/cpu";
+
+
+
+/**
+ * read a single integer from a sysfs file
+ * @param  path file path
+ * @return      value, -1 if the file cannot be read
+ */
+static int readSysInt (const string &path) {
+	ifstream in(path.c_str());
+	int value = -1;
+	if (!(in>>value))
+		return -1;
+	return value;
+}
+
+
+
+/**
+ * parse a CPU list in sysfs/taskset format, like "0-3,8,10-11"
+ * @param  list CPU list
+ * @param  cpus output array of CPU ids, allocated with new[]
+ * @return      number of CPUs, -1 if the list is malformed
+ */
+int parseCpuList (const string &list, int **cpus) {
+	int *result = new int[CPU_SETSIZE];
+	int n = 0;
+	stringstream ss(list);
+	string item;
+	while (getline(ss, item, ',')) {
+		if (item.empty() || item == "\n")
+			continue;
+		int first, last;
+		size_t dash = item.find('-');
+		try {
+			first = stoi(item.substr(0, dash));
+			last = (dash == string::npos) ? first : stoi(item.substr(dash + 1));
+		} catch (...) {
+			delete[] result;
+			return -1;
+		}
+		if (first < 0 || last < first || last >= CPU_SETSIZE) {
+			delete[] result;
+			return -1;
+		}
+		for (int c = first; c <= last && n < CPU_SETSIZE; c++)
+			result[n++] = c;
+	}
+	*cpus = result;
+	return n;
+}
+
+
+
+/**
+ * number of online logical CPUs, the upper bound of every thread count
+ * @return number of CPUs
+ */
+int onlineCpus () {
+	return sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+
+
+/**
+ * read the topology of every online CPU
+ * core and smt are ranks, so sparse core_id numbering does not matter
+ * @param  topo output array, allocated with new[]
+ * @return      number of online CPUs
+ */
+int readTopology (cpu_topo **topo) {
+	string online;
+	ifstream in((string(SYSCPU) + "/online").c_str());
+	int *cpus;
+	int n;
+	if (!getline(in, online) || (n = parseCpuList(online, &cpus)) <= 0) {
+		//no sysfs, treat every CPU as its own core on one package
+		n = onlineCpus();
+		cpus = new int[n];
+		for (int i = 0; i < n; i++)
+			cpus[i] = i;
+	}
+
+	int *coreID = new int[n];
+	cpu_topo *result = new cpu_topo[n];
+	for (int i = 0; i < n; i++) {
+		string dir = string(SYSCPU) + "/cpu" + to_string(cpus[i]) + "/topology/";
+		result[i].cpu = cpus[i];
+		result[i].package = max(0, readSysInt(dir + "physical_package_id"));
+		coreID[i] = readSysInt(dir + "core_id");
+		if (coreID[i] < 0)
+			coreID[i] = cpus[i];
+	}
+
+	//rank cores inside each package, and hyperthreads inside each core
+	for (int i = 0; i < n; i++) {
+		int rank = 0, smt = 0;
+		for (int j = 0; j < n; j++) {
+			if (result[j].package != result[i].package)
+				continue;
+			//count distinct smaller core ids by only counting their first hyperthread
+			if (coreID[j] < coreID[i]) {
+				bool first = true;
+				for (int k = 0; k < j; k++)
+					if (result[k].package == result[j].package && coreID[k] == coreID[j])
+						first = false;
+				if (first)
+					rank++;
+			}
+			if (coreID[j] == coreID[i] && j < i)
+				smt++;
+		}
+		result[i].core = rank;
+		result[i].smt = smt;
+	}
+
+	delete[] coreID;
+	delete[] cpus;
+	*topo = result;
+	return n;
+}
+
+
+
+/**
+ * read the data and unified caches of CPU 0, instruction caches are skipped
+ * @param  caches output array sorted by level, allocated with new[]
+ * @return        number of cache levels, 0 if sysfs has no cache information
+ */
+int readCaches (cache_level **caches) {
+	const int MAXINDEX = 16;		//cache/index0 .. index15
+	cache_level *result = new cache_level[MAXINDEX];
+	int n = 0;
+	for (int i = 0; i < MAXINDEX; i++) {
+		string dir = string(SYSCPU) + "/cpu0/cache/index" + to_string(i) + "/";
+		string type, size;
+		ifstream tin((dir + "type").c_str()), sin((dir + "size").c_str());
+		int level = readSysInt(dir + "level");
+		if (level < 0 || !(tin>>type) || !(sin>>size))
+			continue;
+		if (type == "Instruction")
+			continue;
+		long bytes = atol(size.c_str());		//like "2048K"
+		if (size.back() == 'K')
+			bytes <<= 10;
+		else if (size.back() == 'M')
+			bytes <<= 20;
+		result[n].level = level;
+		result[n].size = bytes;
+		n++;
+	}
+	sort(result, result + n, [](const cache_level &a, const cache_level &b) { return a.level < b.level; });
+	*caches = result;
+	return n;
+}
+
+
+
+/**
+ * map benchmark threads to CPUs
+ * if there are more threads than candidate CPUs, the order wraps around
+ * @param  policy     placement policy
+ * @param  thread_num number of threads
+ * @param  cpulist    CPU list, only used by PIN_LIST
+ * @return            CPU id per thread allocated with new[], NULL for PIN_NONE or on error
+ */
+int *planPlacement (PLACEMENT policy, int thread_num, const string &cpulist) {
+	if (policy == PIN_NONE)
+		return NULL;
+
+	int *cpus = NULL;
+	int n = 0;
+	if (policy == PIN_LIST) {
+		if ((n = parseCpuList(cpulist, &cpus)) <= 0) {
+			cerr<<"Invalid CPU list: "<<cpulist<<endl;
+			return NULL;
+		}
+	} else {
+		cpu_topo *topo;
+		n = readTopology(&topo);
+
+		//each policy is a sort order over (package, core, smt)
+		sort(topo, topo + n, [policy](const cpu_topo &a, const cpu_topo &b) {
+			if (policy == PIN_SCATTER) {
+				if (a.smt != b.smt) return a.smt < b.smt;
+				if (a.core != b.core) return a.core < b.core;
+				return a.package < b.package;
+			} else if (policy == PIN_SMTPAIR) {
+				if (a.package != b.package) return a.package < b.package;
+				if (a.core != b.core) return a.core < b.core;
+				return a.smt < b.smt;
+			} else {	//PIN_COMPACT and PIN_PHYSICAL
+				if (a.package != b.package) return a.package < b.package;
+				if (a.smt != b.smt) return a.smt < b.smt;
+				return a.core < b.core;
+			}
+		});
+
+		cpus = new int[n];
+		int m = 0;
+		for (int i = 0; i < n; i++)
+			if (policy != PIN_PHYSICAL || topo[i].smt == 0)
+				cpus[m++] = topo[i].cpu;
+		n = m;
+		delete[] topo;
+
+		if (policy == PIN_PHYSICAL && thread_num > n) {
+			cerr<<"Only "<<n<<" physical cores available for "<<thread_num<<" threads!"<<endl;
+			delete[] cpus;
+			return NULL;
+		}
+	}
+
+	int *placement = new int[thread_num];
+	for (int i = 0; i < thread_num; i++)
+		placement[i] = cpus[i % n];
+	delete[] cpus;
+	return placement;
+}
+
+
+
+/**
+ * restrict a thread to one CPU before it is created
+ * @param attr thread attribute passed to pthread_create
+ * @param cpu  logical CPU id
+ */
+void pinThreadAttr (pthread_attr_t *attr, int cpu) {
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+	CPU_SET(cpu, &cpuset);
+	if (pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &cpuset) != 0)
+		cerr<<"Cannot pin thread to CPU "<<cpu<<endl;
+}
+
+
+
+/**
+ * pthread_create with optional pinning
+ * @param  thread thread handle
+ * @param  cpu    logical CPU id, -1 leaves the thread unpinned
+ * @param  func   thread function
+ * @param  arg    thread argument
+ * @return        pthread_create return value
+ */
+int createThread (pthread_t *thread, int cpu, void *(*func)(void *), void *arg) {
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	if (cpu >= 0)
+		pinThreadAttr(&attr, cpu);
+	int ret = pthread_create(thread, &attr, func, arg);
+	pthread_attr_destroy(&attr);
+	return ret;
+}
+
+
+
+/**
+ * format the CPU each thread ran on, for the result lines
+ * @param  cpus CPU id per thread
+ * @param  n    number of threads
+ * @return      comma separated list
+ */
+string cpuListString (const int *cpus, int n) {
+	string s;
+	for (int i = 0; i < n; i++) {
+		if (i > 0)
+			s += ",";
+		s += to_string(cpus[i]);
+	}
+	return s;
+}
@@ -0,0 +1,57 @@
+#ifndef _AFFINITY_H_
+#define _AFFINITY_H_
+
+#include <pthread.h>
+#include <string>
+
+/*
+* thread placement policies, shared by cpu, memory and disk benchmarks
+* topology is read from /sys/devices/system/cpu
+ */
+#define PIN_NONE -1		//no pinning, scheduler decides (default)
+#define PIN_COMPACT 0	//fill one socket before the next, physical cores before SMT siblings
+#define PIN_SCATTER 1	//round-robin over sockets, then cores, SMT siblings last
+#define PIN_PHYSICAL 2	//one thread per physical core, SMT siblings never used
+#define PIN_SMTPAIR 3	//threads 2k and 2k+1 share the two hyperthreads of one core
+#define PIN_LIST 4		//explicit CPU list given by the user
+#define NUM_PLACEMENT 5
+
+typedef int PLACEMENT;		//placement policy
+
+extern const char* placement_name[];
+
+
+/*
+* one online logical CPU
+ */
+typedef struct {
+	int cpu;		//logical CPU id
+	int package;	//physical package (socket) id
+	int core;		//rank of the core inside its package
+	int smt;		//rank of this hyperthread among the siblings of its core
+} cpu_topo;
+
+
+/*
+* one data or unified cache level seen by CPU 0
+ */
+typedef struct {
+	int level;		//1 = L1d, 2 = L2, ...
+	long size;		//bytes
+} cache_level;
+
+
+/*
+* functions declarations
+ */
+int onlineCpus ();
+int readTopology (cpu_topo **topo);
+int readCaches (cache_level **caches);
+int parseCpuList (const std::string &list, int **cpus);
+int *planPlacement (PLACEMENT policy, int thread_num, const std::string &cpulist);
+void pinThreadAttr (pthread_attr_t *attr, int cpu);
+int createThread (pthread_t *thread, int cpu, void *(*func)(void *), void *arg);
+std::string cpuListString (const int *cpus, int n);
+
+
+#endif
@@ -0,0 +1,641 @@
+/**
+ * @file allocator_benchmark.cpp
+ * benchmark for memory allocators under thread contention
+ *
+ * every thread allocates blocks of a size distribution, touches them and frees them again,
+ * either its own blocks a batch at a time or, producer/consumer, the blocks of its neighbour,
+ * with the system malloc, new[], or the built-in per-thread arena and pool allocators
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>		//readRss
+#include <ctime>
+#include <sched.h>		//sched_getcpu, sched_yield
+#include <unistd.h>		//getopt, sysconf
+#include <getopt.h>		//getopt_long
+#include <cstring>		//memset
+#include <new>			//placement new
+#include <string>
+#include <sys/resource.h>	//getrusage
+#include "allocator_benchmark.h"
+
+using namespace std;
+
+
+
+/**
+ * user manual, help user how to give input
+ */
+void helper (char *arg) {
+	cout<<arg<<": Allocator benchmark tool, Version 0.0.1 (lchen96@hawk.iit.edu)"<<endl<<endl;
+	cout<<"usage:\t"<<arg<<" [-h] [-a <allocator>] [-d <sizes>] [-x <pattern>] [-t <threads>] [-n <allocations>] [-r <repeats>] [-p <placement>] [-c <cpulist>] [--sweep-threads[=linear|pow2]]"<<endl;
+	cout<<"Arguments:"<<endl;
+	cout<<"\t-h\tlist available commands"<<endl;
+	cout<<"\t-a\tallocator, malloc=0, new[]=1, per-thread arena=2, per-thread size-class pool=3 [default = all]"<<endl;
+	cout<<"\t-d\tsize distribution, small 16B-256B=0, mixed=1 (defaulted, 90% 16B-256B, 9% to 4KB, 1% to 64KB), large 4KB-1MB=2"<<endl;
+	cout<<"\t-x\tfree pattern, every thread frees its own blocks=0 (defaulted),"<<endl
+		<<"\t\tproducer/consumer=1 (thread i frees the blocks of thread i-1, the arena cannot take part)"<<endl;
+	cout<<"\t-t\tnumber of threads ( <= "<<onlineCpus()<<" online CPUs) [default = 1]"<<endl;
+	cout<<"\t-n\ttotal number of allocations, split among the threads [default = 1e7]"<<endl;
+	cout<<"\t-r\tnumber of repeated benchmark tests[default = 1]"<<endl;
+	cout<<"\t-p\tthread placement, compact=0, scatter=1, physical cores only=2, SMT pairs=3 [default = unpinned]"<<endl;
+	cout<<"\t-c\tpin threads to an explicit CPU list, like 0-3,8"<<endl;
+	cout<<"\t--sweep-threads\trun every thread count from 1 to -t (default: all online CPUs) for each allocator,"<<endl
+		<<"\t\tlinear or powers of two (defaulted), and report speedup, efficiency and the serial fraction"<<endl;
+	cout<<endl;
+}
+
+
+
+int main (int argc, char *argv[]) {
+	/*
+	use getopt function to parse the input arguments
+	 */
+	int c;
+	static struct option long_options[] = {
+		{"sweep-threads", optional_argument, NULL, SWEEP_OPT},
+		{0, 0, 0, 0}
+	};
+	// only accepts "hadxtnrpc" arguments, where for "adxtnrp" the argument can be optional
+	while ((c = getopt_long (argc, argv, ":ha::d::x::t::n::r::p::c:", long_options, NULL)) != -1)
+		switch (c) {
+			case 'h':
+				helper(argv[0]);
+				exit(0);
+			case 'a':
+				alloc_select = stoi(optarg);
+				if (alloc_select < ALLOC_MALLOC || alloc_select >= NUM_ALLOC) {
+					cerr<<"allocator can only be 0 to "<<NUM_ALLOC - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'd':
+				size_dist = stoi(optarg);
+				if (size_dist < SIZE_SMALL || size_dist >= NUM_SIZE) {
+					cerr<<"size distribution can only be 0 to "<<NUM_SIZE - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'x':
+				pattern = stoi(optarg);
+				if (pattern < PATTERN_LOCAL || pattern >= NUM_PATTERN) {
+					cerr<<"free pattern can only be 0 to "<<NUM_PATTERN - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 't':
+				thread_num = atoi(optarg);
+				if (thread_num < 1 || thread_num > onlineCpus()) {
+					cout<<"Thread number must be 1 to the online CPU count ("<<onlineCpus()<<")!"<<endl;
+					exit(2);
+				}
+				thread_set = true;
+				break;
+			case 'n':
+				allocs_num = (long)atof(optarg);	//accept exponent input like 1e8
+				if (allocs_num < 1) {
+					cerr<<"number of allocations must be positive!\n"<<endl;
+					exit(1);
+				}
+				break;
+			case 'r':
+				repeat_num = stoi(optarg);
+				break;
+			case 'p':
+				placement = stoi(optarg);
+				if (placement < PIN_COMPACT || placement >= PIN_LIST) {
+					cerr<<"placement can only be 0 to "<<PIN_LIST - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'c':
+				placement = PIN_LIST;
+				cpu_list = optarg;
+				break;
+			case SWEEP_OPT:
+				if ((sweep_mode = parseSweepMode(optarg)) == -1) {
+					cerr<<"sweep can only be linear or pow2!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case ':':	/*missing option argument, using default value*/
+				if (optopt == 'a')
+					alloc_select = ALL_ALLOC;
+				else if (optopt == 'd')
+					size_dist = SIZE_MIXED;
+				else if (optopt == 'x')
+					pattern = PATTERN_LOCAL;
+				else if (optopt == 't')
+					thread_num = 1;
+				else if (optopt == 'n')
+					allocs_num = DEFAULTALLOCS;
+				else if (optopt == 'r')
+					repeat_num = 1;
+				else if (optopt == 'p')
+					placement = PIN_COMPACT;
+				break;
+			case '?':	/* invalid option*/
+			default:
+				cerr<<"Invalid arguments!\n"<<endl;
+				helper(argv[0]);
+				abort();
+		}
+
+
+		if (pattern == PATTERN_HANDOFF && alloc_select == ALLOC_ARENA) {
+			cerr<<"the arena frees in bulk by its owner, producer/consumer frees need malloc, new or pool!\n"<<endl;
+			exit(1);
+		}
+
+		if (sweep_mode != SWEEP_NONE && !thread_set)
+			thread_num = onlineCpus();
+
+		pinCpu = planPlacement(placement, thread_num, cpu_list);
+		if (placement != PIN_NONE && pinCpu == NULL)
+			exit(1);
+
+		/*
+		print user's input information
+		 */
+		cout<<"\nThe benchmarking begins with:"
+			<<"\n\tAllocator:\t\t"<<(alloc_select == ALL_ALLOC ? "all" : alloc_name[alloc_select])
+			<<"\n\tSizes:\t\t\t"<<size_name[size_dist]
+			<<"\n\tFree pattern:\t\t"<<pattern_name[pattern]
+			<<"\n\t#Thread:\t\t"<<(sweep_mode == SWEEP_NONE ? to_string(thread_num) : "sweep 1 to " + to_string(thread_num) + " (" + sweep_name[sweep_mode] + ")")
+			<<"\n\tPlacement:\t\t"<<(placement == PIN_NONE ? "unpinned" : placement_name[placement] + string(" (") + cpuListString(pinCpu, thread_num) + ")")
+			<<"\n\t#Allocation:\t\t"<<allocs_num
+			<<"\n\t#Iteration:\t\t"<<repeat_num<<endl<<endl<<endl;
+
+		//state and rings are shared between cores, so they start on a cache line
+		if (posix_memalign((void **)&allocState, CACHELINE, thread_num * sizeof(alloc_state)) != 0
+			|| posix_memalign((void **)&rings, CACHELINE, thread_num * sizeof(handoff_ring)) != 0) {
+			cerr<<"Fail to allocate the allocator state!"<<endl;
+			exit(1);
+		}
+		memset(allocState, 0, thread_num * sizeof(alloc_state));
+		for (int i = 0; i < thread_num; i++)
+			new (&rings[i]) handoff_ring();		//value-initialised in place: atomics must not be memset
+		batchBlocks = new alloc_block*[thread_num];
+		latHist = new latency_hist*[thread_num];
+		for (int i = 0; i < thread_num; i++) {
+			batchBlocks[i] = new alloc_block[ALLOC_BATCH];
+			latHist[i] = new latency_hist;		//fixed size whatever -n is, one allocation per thread so no line is shared
+			histReset(latHist[i]);		//resident before rss_start
+		}
+		ranCpu = new int[thread_num];
+		clock_overhead = measureClockOverhead();
+		rss_start = readRss();
+
+		for (alloc_type = ALLOC_MALLOC; alloc_type < NUM_ALLOC; alloc_type++) {
+			if (alloc_select != ALL_ALLOC && alloc_type != alloc_select)
+				continue;
+			if (alloc_type == ALLOC_ARENA && pattern == PATTERN_HANDOFF) {
+				cout<<"arena skipped, it frees in bulk by its owner and has no producer/consumer mode"<<endl<<endl;
+				continue;
+			}
+
+			cout<<"Allocator\tSizes\tPattern\t#Thread\tThroughput(Mallocs/sec)\tp50(ns)\tp99(ns)\tRSS growth(MB)\tPeak RSS(MB)\tTime(us)\tCPUs"<<endl;
+			if (sweep_mode == SWEEP_NONE)
+				runThreadCount(thread_num);
+			else {
+				int *counts;
+				int steps = sweepThreadCounts(sweep_mode, thread_num, &counts);
+				double *rate = new double[steps];
+				for (int s = 0; s < steps; s++)
+					rate[s] = runThreadCount(counts[s]);
+				printScalingReport(counts, rate, steps, "Mallocs/s");
+				delete[] rate;
+				delete[] counts;
+			}
+			cout<<endl;
+		}
+
+		for (int i = 0; i < thread_num; i++) {
+			delete[] batchBlocks[i];
+			delete latHist[i];
+		}
+		delete[] batchBlocks;
+		delete[] latHist;
+		free(allocState);
+		free(rings);
+		delete[] pinCpu;
+		delete[] ranCpu;
+
+		return 0;
+}
+
+
+
+/**
+ * time of an empty clock_gettime pair, the floor of every latency sample
+ * @return nanoseconds, minimum of 1000 pairs
+ */
+double measureClockOverhead () {
+	double best = 1e9;
+	for (int i = 0; i < 1000; i++) {
+		struct timespec t0, t1;
+		clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+		clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+		double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+		if (ns < best)
+			best = ns;
+	}
+	return best;
+}
+
+
+
+/**
+ * resident set size of the process, from /proc/self/statm
+ * @return bytes, 0 if statm cannot be read
+ */
+long readRss () {
+	ifstream in("/proc/self/statm");
+	long pages = 0, resident = 0;
+	if (!(in>>pages>>resident))
+		return 0;
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+
+
+/**
+ * highest resident set size the process has reached
+ * @return bytes
+ */
+long peakRss () {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss * 1024L;		//KB on Linux
+}
+
+
+
+/**
+ * hand the chunks of every arena and pool back to malloc and empty the free lists
+ * called between runs, when no block of the arenas and pools is live any more
+ * @param n thread count
+ */
+void releaseState (int n) {
+	for (int i = 0; i < n; i++) {
+		alloc_state *st = &allocState[i];
+		for (chunk_head *ch = st->arenaFirst, *next; ch != NULL; ch = next) {
+			next = ch->next;
+			free(ch);
+		}
+		for (chunk_head *ch = st->poolChunks, *next; ch != NULL; ch = next) {
+			next = ch->next;
+			free(ch);
+		}
+		memset(st, 0, sizeof(alloc_state));
+	}
+}
+
+
+
+/**
+ * p50 and p99 of the allocation latency samples of all threads of the last run,
+ * from the merged per-thread histograms
+ * @param n   thread count
+ * @param p50 output, ns
+ * @param p99 output, ns
+ */
+void latencyPercentiles (int n, double *p50, double *p99) {
+	latency_hist all;
+	histReset(&all);
+	for (int i = 0; i < n; i++)
+		histMerge(&all, latHist[i]);
+	*p50 = histPercentile(&all, 50);
+	*p99 = histPercentile(&all, 99);
+}
+
+
+
+/**
+ * split the allocations among n threads and run the benchmark repeat_num times on a pool of n workers
+ * the workers are pinned to the first n CPUs of the placement
+ * @param  n thread count
+ * @return   best throughput of the repeats, in Mallocs/s
+ */
+double runThreadCount (int n) {
+	thread_num = n;
+
+	allocsPerThrd = new long[thread_num];
+	for (int i = 0; i < thread_num; i++)
+		allocsPerThrd[i] = allocs_num / thread_num + (i < allocs_num % thread_num);
+	double *thrdMallocs = new double[thread_num];		//allocations of each thread, for the per-thread report
+	for (int i = 0; i < thread_num; i++)
+		thrdMallocs[i] = allocsPerThrd[i] / 1e6;
+
+	double best = 0;
+	poolCreate(thread_num, pinCpu);
+	for (int i = 0; i < repeat_num; i++) {
+		for (int j = 0; j < thread_num; j++) {
+			rings[j].head.store(0);
+			rings[j].tail.store(0);
+			rings[j].done.store(false);
+		}
+		double runtime = allocator_benchmark();
+		//memory the allocator kept after every block was freed, before the arenas and pools are released
+		long rss = readRss();
+		releaseState(thread_num);
+
+		double p50, p99;
+		latencyPercentiles(thread_num, &p50, &p99);
+		double rate = allocs_num / runtime / 1e6;
+		if (rate > best)
+			best = rate;
+		cout<<"#Iter "<<i<<"\t"<<alloc_name[alloc_type]<<"\t"<<size_name[size_dist]<<"\t"<<pattern_name[pattern]<<"\t"<<thread_num
+			<<"\t"<<rate<<"Mallocs/s\t"<<p50<<"ns\t"<<p99<<"ns"
+			<<"\t"<<(rss - rss_start) / 1048576.0<<"MB\t"<<peakRss() / 1048576.0<<"MB"
+			<<"\t"<<runtime * 1e6<<"us\t"<<cpuListString(ranCpu, thread_num)<<endl;
+		printThreadReport(thrdMallocs, "Mallocs/s", ranCpu);
+	}
+	poolDestroy();
+
+	delete[] thrdMallocs;
+	delete[] allocsPerThrd;
+
+	return best;
+}
+
+
+/**
+ * allocator benchmark function implementation
+ * @return benchmarking time in seconds
+ */
+double allocator_benchmark () {
+	run_id++;
+	//workers already exist, only barrier release to last finish is timed
+	if (pattern == PATTERN_LOCAL)
+		return poolRun(localThread);
+	else if (pattern == PATTERN_HANDOFF)
+		return poolRun(handoffThread);
+
+	cerr<<"Invalid structions! pattern can only be 0 to "<<NUM_PATTERN - 1<<"!"<<endl;
+	abort();
+}
+
+
+
+/*
+* block sizes are drawn with xorshift64*, one generator per thread
+* the state comes from splitmix64 of (run, thread), so every repeat and thread gets its own stream
+ */
+static inline uint64_t splitmix64 (uint64_t x) {
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+static inline uint64_t xorshift64s (uint64_t &state) {
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 0x2545F4914F6CDD1DULL;
+}
+
+static inline size_t drawSize (uint64_t &state) {
+	uint64_t r = xorshift64s(state);
+	if (size_dist == SIZE_SMALL)
+		return 16 * (1 + (r >> 32) % 16);
+	if (size_dist == SIZE_LARGE) {
+		size_t base = 4096UL << (r % 8);		//4KB to 512KB, plus up to the same again
+		return base + (r >> 32) % base;
+	}
+	uint64_t p = r % 100;
+	if (p < 90)
+		return 16 * (1 + (r >> 32) % 16);
+	if (p < 99)
+		return 256 + (r >> 32) % (4096 - 256);
+	return 4096 + (r >> 32) % (65536 - 4096);
+}
+
+
+
+/*
+* arena: bump allocation in 4MB chunks, a free is a no-op and a reset rewinds to the first chunk,
+* so the chunks are reused and only a deeper batch than before asks malloc for more
+ */
+static inline void *arenaAlloc (alloc_state *st, size_t size) {
+	size = (size + ALLOC_ALIGN - 1) & ~(ALLOC_ALIGN - 1);
+	if (st->arenaCrt == NULL || st->arenaUsed + size > st->arenaCrt->size) {
+		chunk_head *next = st->arenaCrt ? st->arenaCrt->next : st->arenaFirst;
+		if (next == NULL) {
+			next = (chunk_head *)malloc(ARENA_CHUNK);
+			next->next = NULL;
+			next->size = ARENA_CHUNK;
+			if (st->arenaCrt)
+				st->arenaCrt->next = next;
+			else
+				st->arenaFirst = next;
+		}
+		st->arenaCrt = next;
+		st->arenaUsed = (sizeof(chunk_head) + ALLOC_ALIGN - 1) & ~(ALLOC_ALIGN - 1);
+	}
+	void *p = (char *)st->arenaCrt + st->arenaUsed;
+	st->arenaUsed += size;
+	return p;
+}
+
+static inline void arenaReset (alloc_state *st) {
+	st->arenaCrt = NULL;
+	st->arenaUsed = 0;
+}
+
+
+/*
+* pool: one free list per power-of-two class from 16B to 64KB, refilled by carving a 1MB chunk
+* a block goes back to the list of the thread that frees it, so under producer/consumer
+* the blocks migrate from thread to thread as in thread-caching allocators
+ */
+static inline int poolClass (size_t size) {
+	if (size <= (1UL << POOL_MINSHIFT))
+		return 0;
+	return 64 - __builtin_clzl(size - 1) - POOL_MINSHIFT;
+}
+
+static inline void *poolAlloc (alloc_state *st, size_t size) {
+	int cls = poolClass(size);
+	if (cls >= POOL_CLASSES)
+		return malloc(size);
+	if (st->freeList[cls] == NULL) {
+		size_t block = 1UL << (cls + POOL_MINSHIFT);
+		chunk_head *ch = (chunk_head *)malloc(POOL_CHUNK);
+		ch->next = st->poolChunks;
+		ch->size = POOL_CHUNK;
+		st->poolChunks = ch;
+		for (char *p = (char *)ch + CACHELINE; p + block <= (char *)ch + POOL_CHUNK; p += block) {
+			*(void **)p = st->freeList[cls];
+			st->freeList[cls] = p;
+		}
+	}
+	void *p = st->freeList[cls];
+	st->freeList[cls] = *(void **)p;
+	return p;
+}
+
+static inline void poolFree (alloc_state *st, void *p, size_t size) {
+	int cls = poolClass(size);
+	if (cls >= POOL_CLASSES) {
+		free(p);
+		return;
+	}
+	*(void **)p = st->freeList[cls];
+	st->freeList[cls] = p;
+}
+
+
+static inline void *allocBlock (alloc_state *st, size_t size) {
+	if (alloc_type == ALLOC_MALLOC)
+		return malloc(size);
+	else if (alloc_type == ALLOC_NEW)
+		return new char[size];
+	else if (alloc_type == ALLOC_ARENA)
+		return arenaAlloc(st, size);
+	return poolAlloc(st, size);
+}
+
+static inline void freeBlock (alloc_state *st, void *p, size_t size) {
+	if (alloc_type == ALLOC_MALLOC)
+		free(p);
+	else if (alloc_type == ALLOC_NEW)
+		delete[] (char *)p;
+	else if (alloc_type == ALLOC_POOL)
+		poolFree(st, p, size);
+	//arena: freed in bulk by arenaReset
+}
+
+
+/*
+* allocation of the i-th block of a thread, every ALLOC_SAMPLE-th one is timed
+* the first word is written, so the allocator cannot hand out memory it never backs
+ */
+static inline void *sampledAlloc (int id, alloc_state *st, size_t size, long i) {
+	void *p;
+	if ((i & (ALLOC_SAMPLE - 1)) == 0) {
+		struct timespec t0, t1;
+		clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+		p = allocBlock(st, size);
+		clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+		double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec) - clock_overhead;
+		histRecord(latHist[id], ns > 0 ? (uint64_t)(ns + 0.5) : 0);
+	} else
+		p = allocBlock(st, size);
+	*(long *)p = i;
+	return p;
+}
+
+
+/**
+ * local thread implementation, allocates ALLOC_BATCH blocks, then frees them in a random order
+ * the order is a multiplication by an odd stride modulo the batch, a permutation of the slots
+ * @param  argv thread ID
+ * @return      exit current thread once it completes without being suspended
+ */
+void *localThread (void *argv) {
+	int crtThrdID = *(int *)argv;
+	alloc_state *st = &allocState[crtThrdID];
+	alloc_block *blocks = batchBlocks[crtThrdID];
+	uint64_t state = splitmix64(run_id * thread_num + crtThrdID) | 1;		//xorshift state must not be 0
+	histReset(latHist[crtThrdID]);
+
+	long total = allocsPerThrd[crtThrdID];
+	for (long done = 0; done < total; ) {
+		int batch = total - done < ALLOC_BATCH ? total - done : ALLOC_BATCH;
+		for (int j = 0; j < batch; j++) {
+			blocks[j].size = drawSize(state);
+			blocks[j].ptr = sampledAlloc(crtThrdID, st, blocks[j].size, done + j);
+		}
+		if (batch == ALLOC_BATCH) {
+			unsigned stride = xorshift64s(state) | 1;
+			for (unsigned j = 0; j < ALLOC_BATCH; j++) {
+				alloc_block *b = &blocks[(j * stride) & (ALLOC_BATCH - 1)];
+				freeBlock(st, b->ptr, b->size);
+			}
+		} else
+			for (int j = batch - 1; j >= 0; j--)
+				freeBlock(st, blocks[j].ptr, blocks[j].size);
+		if (alloc_type == ALLOC_ARENA)
+			arenaReset(st);
+		done += batch;
+	}
+
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+/*
+* producer/consumer ring operations, the producer owns tail and the consumer owns head
+ */
+static inline bool ringPush (handoff_ring *ring, void *ptr, size_t size) {
+	long tail = ring->tail.load(memory_order_relaxed);
+	if (tail - ring->head.load(memory_order_acquire) == ALLOC_RING)
+		return false;
+	ring->slot[tail & (ALLOC_RING - 1)].ptr = ptr;
+	ring->slot[tail & (ALLOC_RING - 1)].size = size;
+	ring->tail.store(tail + 1, memory_order_release);
+	return true;
+}
+
+static inline bool ringFree (handoff_ring *ring, alloc_state *st) {
+	long head = ring->head.load(memory_order_relaxed);
+	if (head == ring->tail.load(memory_order_acquire))
+		return false;
+	alloc_block b = ring->slot[head & (ALLOC_RING - 1)];
+	ring->head.store(head + 1, memory_order_release);
+	freeBlock(st, b.ptr, b.size);
+	return true;
+}
+
+
+/**
+ * producer/consumer thread implementation
+ * every block goes to the ring of this thread and is freed by the next thread, which
+ * in turn frees the blocks of the previous thread, one per allocation, more while its own ring is full
+ * @param  argv thread ID
+ * @return      exit current thread once it completes without being suspended
+ */
+void *handoffThread (void *argv) {
+	int crtThrdID = *(int *)argv;
+	alloc_state *st = &allocState[crtThrdID];
+	handoff_ring *out = &rings[crtThrdID];
+	handoff_ring *in = &rings[(crtThrdID + thread_num - 1) % thread_num];
+	uint64_t state = splitmix64(run_id * thread_num + crtThrdID) | 1;
+	histReset(latHist[crtThrdID]);
+
+	for (long i = 0; i < allocsPerThrd[crtThrdID]; i++) {
+		size_t size = drawSize(state);
+		void *p = sampledAlloc(crtThrdID, st, size, i);
+		while (!ringPush(out, p, size))
+			if (!ringFree(in, st))
+				sched_yield();		//both rings stalled, let an oversubscribed consumer run
+		ringFree(in, st);
+	}
+	out->done.store(true, memory_order_release);
+
+	//the producer is finished once its flag is up and its ring is empty
+	for (;;) {
+		bool finished = in->done.load(memory_order_acquire);
+		if (ringFree(in, st))
+			continue;
+		if (finished)
+			break;
+		sched_yield();
+	}
+
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
@@ -0,0 +1,144 @@
+#ifndef _ALLOCATOR_H_
+#define _ALLOCATOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "affinity.h"
+#include "worker_pool.h"
+#include "scaling.h"
+#include "latency_hist.h"
+
+
+#define ALLOC_MALLOC 0	//malloc and free
+#define ALLOC_NEW 1		//new[] and delete[]
+#define ALLOC_ARENA 2	//per-thread bump arena, frees are no-ops and the arena is reset after each batch
+#define ALLOC_POOL 3	//per-thread free lists of power-of-two size classes, larger blocks go to malloc
+#define NUM_ALLOC 4
+#define ALL_ALLOC -1	//run every allocator
+
+#define SIZE_SMALL 0	//16B to 256B in 16B steps
+#define SIZE_MIXED 1	//90% 16B-256B, 9% 256B-4KB, 1% 4KB-64KB
+#define SIZE_LARGE 2	//4KB to 1MB, log-uniform
+#define NUM_SIZE 3
+
+#define PATTERN_LOCAL 0		//every thread frees its own blocks, a batch at a time in random order
+#define PATTERN_HANDOFF 1		//producer/consumer: thread i frees the blocks of thread i-1, passed through a ring
+#define NUM_PATTERN 2
+
+#define CACHELINE 64L
+#define ALLOC_ALIGN 16L		//alignment of arena and pool blocks, as malloc gives
+#define ALLOC_MAXSIZE 1048576L	//largest block of every distribution
+#define ALLOC_BATCH 256		//blocks a thread holds before freeing them, power of two
+#define ALLOC_RING 1024		//producer/consumer: blocks in flight between two threads, power of two
+#define ALLOC_SAMPLE 16		//every 16th allocation is timed for the latency percentiles, power of two
+#define ARENA_CHUNK 4194304L	//4MB chunks of the arena, larger than any block
+#define POOL_MINSHIFT 4		//smallest pool class 16B
+#define POOL_CLASSES 13		//16B to 64KB
+#define POOL_CHUNK 1048576L	//1MB carved into blocks of one class on a free-list miss
+
+typedef int ALLOCATOR;		//allocator
+typedef int SIZE_DIST;		//size distribution
+typedef int PATTERN;		//free pattern
+
+
+const long DEFAULTALLOCS = 1e7;
+
+const char* alloc_name[] = {"malloc", "new", "arena", "pool"};
+const char* size_name[] = {"small", "mixed", "large"};
+const char* pattern_name[] = {"local", "producer/consumer"};
+
+
+/*
+* a block passed from its producer to the thread that frees it
+ */
+typedef struct {
+	void *ptr;
+	size_t size;
+} alloc_block;
+
+
+/*
+* single-producer single-consumer ring between two threads
+* head and tail sit on lines of their own, so only the ring slots move between the cores
+ */
+typedef struct {
+	std::atomic<long> head;		//next slot the consumer pops
+	char pad0[CACHELINE - sizeof(std::atomic<long>)];
+	std::atomic<long> tail;		//next slot the producer pushes
+	char pad1[CACHELINE - sizeof(std::atomic<long>)];
+	std::atomic<bool> done;		//the producer pushed its last block
+	char pad2[CACHELINE - sizeof(std::atomic<bool>)];
+	alloc_block slot[ALLOC_RING];
+} handoff_ring;
+
+
+/*
+* chunk of an arena or a pool, the header sits in front of the memory handed out
+ */
+typedef struct chunk_head {
+	struct chunk_head *next;
+	size_t size;
+} chunk_head;
+
+
+/*
+* allocator state of one thread, only the owner allocates from it
+ */
+typedef struct {
+	chunk_head *arenaFirst;		//chunks of the arena, kept across resets
+	chunk_head *arenaCrt;		//chunk bumped into
+	size_t arenaUsed;		//bytes used in arenaCrt, header included
+	void *freeList[POOL_CLASSES];		//free blocks of each class, linked through their first word
+	chunk_head *poolChunks;		//chunks carved for the pool
+	char pad[CACHELINE];
+} alloc_state;
+
+
+/*
+global variables
+ */
+ALLOCATOR alloc_select = ALL_ALLOC;		//allocator, default = all
+SIZE_DIST size_dist = SIZE_MIXED;		//size distribution, default = mixed
+PATTERN pattern = PATTERN_LOCAL;		//free pattern, default = local
+int thread_num = 1;		//thread num, default = 1
+bool thread_set = false;		//thread num given by the user
+SWEEP sweep_mode = SWEEP_NONE;		//thread-scaling sweep, default = single run
+long allocs_num = DEFAULTALLOCS;		//total allocations of one run, split among the threads
+int repeat_num = 1;		//repeat test num, default = 1
+PLACEMENT placement = PIN_NONE;		//thread placement policy, default = unpinned
+std::string cpu_list;		//explicit CPU list for PIN_LIST
+
+ALLOCATOR alloc_type;		//allocator of the current run
+long run_id = 0;		//counts the timed runs, seeds the size draws
+double clock_overhead;		//ns of an empty clock_gettime pair, taken off every latency sample
+long rss_start;		//resident bytes before the first run
+
+alloc_state* allocState;		//allocator state of each thread
+handoff_ring* rings;		//producer/consumer: ring of each producer, consumed by the next thread
+alloc_block** batchBlocks;		//local: blocks each thread holds, ALLOC_BATCH per thread
+long* allocsPerThrd;		//allocations of each thread
+latency_hist** latHist;		//latency samples of each thread in the last run, in ns
+
+int* pinCpu;		//CPU each thread is pinned to, NULL if unpinned
+int* ranCpu;		//CPU each thread actually ran on, recorded when the thread finishes
+
+
+/*
+functions declarations
+ */
+void helper (char *arg);
+double measureClockOverhead ();
+long readRss ();
+long peakRss ();
+void releaseState (int n);
+void latencyPercentiles (int n, double *p50, double *p99);
+double runThreadCount (int n);
+double allocator_benchmark ();
+void *localThread (void *argv);
+void *handoffThread (void *argv);
+
+
+
+#endif
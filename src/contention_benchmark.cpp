@@ -0,0 +1,360 @@
+/**
+ * @file contention_benchmark.cpp
+ * benchmark for cache-line contention: atomic read-modify-write and false sharing
+ *
+ * every thread runs fetch_add, compare-and-swap or exchange on a 64-bit counter in a loop,
+ * the counters are laid out on one shared line, on one line per thread, or packed next to each other,
+ * the last layout shares nothing in the program but still ping-pongs the lines between the cores
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sched.h>		//sched_getcpu
+#include <unistd.h>		//getopt
+#include <getopt.h>		//getopt_long
+#include <cstring>		//memset
+#include <string>
+#include <new>		//placement new
+#include "contention_benchmark.h"
+
+using namespace std;
+
+
+
+/**
+ * user manual, help user how to give input
+ */
+void helper (char *arg) {
+	cout<<arg<<": Cache-line contention benchmark tool, Version 0.0.1 (lchen96@hawk.iit.edu)"<<endl<<endl;
+	cout<<"usage:\t"<<arg<<" [-h] [-o <operation>] [-l <layout>] [-t <threads>] [-n <operations>] [-r <repeats>] [-p <placement>] [-c <cpulist>] [--sweep-threads[=linear|pow2]]"<<endl;
+	cout<<"Arguments:"<<endl;
+	cout<<"\t-h\tlist available commands"<<endl;
+	cout<<"\t-o\tatomic operation, fetch_add=0, CAS loop=1, exchange=2 [default = all]"<<endl;
+	cout<<"\t-l\tcounter layout, one shared line=0, padded line per thread=1, adjacent 8-byte counters (false sharing)=2 [default = all]"<<endl;
+	cout<<"\t-t\tnumber of threads ( <= "<<onlineCpus()<<" online CPUs) [default = 1]"<<endl;
+	cout<<"\t-n\ttotal number of atomic operations, split among the threads [default = 2e7]"<<endl;
+	cout<<"\t-r\tnumber of repeated benchmark tests[default = 1]"<<endl;
+	cout<<"\t-p\tthread placement, compact=0, scatter=1, physical cores only=2, SMT pairs=3 [default = unpinned]"<<endl;
+	cout<<"\t-c\tpin threads to an explicit CPU list, like 0-3,8"<<endl;
+	cout<<"\t--sweep-threads\trun every thread count from 1 to -t (default: all online CPUs) for each operation and layout,"<<endl
+		<<"\t\tlinear or powers of two (defaulted), and report speedup, efficiency and the serial fraction"<<endl;
+	cout<<endl;
+}
+
+
+
+int main (int argc, char *argv[]) {
+	/*
+	use getopt function to parse the input arguments
+	 */
+	int c;
+	static struct option long_options[] = {
+		{"sweep-threads", optional_argument, NULL, SWEEP_OPT},
+		{0, 0, 0, 0}
+	};
+	// only accepts "holtnrpc" arguments, where for "oltnrp" the argument can be optional
+	while ((c = getopt_long (argc, argv, ":ho::l::t::n::r::p::c:", long_options, NULL)) != -1)
+		switch (c) {
+			case 'h':
+				helper(argv[0]);
+				exit(0);
+			case 'o':
+				op_select = stoi(optarg);
+				if (op_select < FETCH_ADD || op_select >= NUM_OP) {
+					cerr<<"operation can only be 0 to "<<NUM_OP - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'l':
+				layout_select = stoi(optarg);
+				if (layout_select < SHARED || layout_select >= NUM_LAYOUT) {
+					cerr<<"layout can only be 0 to "<<NUM_LAYOUT - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 't':
+				thread_num = atoi(optarg);
+				if (thread_num < 1 || thread_num > onlineCpus()) {
+					cout<<"Thread number must be 1 to the online CPU count ("<<onlineCpus()<<")!"<<endl;
+					exit(2);
+				}
+				thread_set = true;
+				break;
+			case 'n':
+				ops_num = (long)atof(optarg);	//accept exponent input like 1e8
+				if (ops_num < 1) {
+					cerr<<"number of operations must be positive!\n"<<endl;
+					exit(1);
+				}
+				break;
+			case 'r':
+				repeat_num = stoi(optarg);
+				break;
+			case 'p':
+				placement = stoi(optarg);
+				if (placement < PIN_COMPACT || placement >= PIN_LIST) {
+					cerr<<"placement can only be 0 to "<<PIN_LIST - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'c':
+				placement = PIN_LIST;
+				cpu_list = optarg;
+				break;
+			case SWEEP_OPT:
+				if ((sweep_mode = parseSweepMode(optarg)) == -1) {
+					cerr<<"sweep can only be linear or pow2!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case ':':	/*missing option argument, using default value*/
+				if (optopt == 'o')
+					op_select = ALL_OP;
+				else if (optopt == 'l')
+					layout_select = ALL_LAYOUT;
+				else if (optopt == 't')
+					thread_num = 1;
+				else if (optopt == 'n')
+					ops_num = DEFAULTOPS;
+				else if (optopt == 'r')
+					repeat_num = 1;
+				else if (optopt == 'p')
+					placement = PIN_COMPACT;
+				break;
+			case '?':	/* invalid option*/
+			default:
+				cerr<<"Invalid arguments!\n"<<endl;
+				helper(argv[0]);
+				abort();
+		}
+
+
+		if (sweep_mode != SWEEP_NONE && !thread_set)
+			thread_num = onlineCpus();
+
+		pinCpu = planPlacement(placement, thread_num, cpu_list);
+		if (placement != PIN_NONE && pinCpu == NULL)
+			exit(1);
+
+		/*
+		print user's input information
+		 */
+		cout<<"\nThe benchmarking begins with:"
+			<<"\n\tOperation:\t\t"<<(op_select == ALL_OP ? "all" : op_name[op_select])
+			<<"\n\tLayout:\t\t\t"<<(layout_select == ALL_LAYOUT ? "all" : layout_name[layout_select])
+			<<"\n\t#Thread:\t\t"<<(sweep_mode == SWEEP_NONE ? to_string(thread_num) : "sweep 1 to " + to_string(thread_num) + " (" + sweep_name[sweep_mode] + ")")
+			<<"\n\tPlacement:\t\t"<<(placement == PIN_NONE ? "unpinned" : placement_name[placement] + string(" (") + cpuListString(pinCpu, thread_num) + ")")
+			<<"\n\t#Operation:\t\t"<<ops_num
+			<<"\n\t#Iteration:\t\t"<<repeat_num<<endl<<endl<<endl;
+
+		//one line per thread covers every layout, the false-sharing counters fill the first lines only
+		if (posix_memalign((void **)&counterMem, CACHELINE, thread_num * CACHELINE) != 0) {
+			cerr<<"Fail to allocate the counters!"<<endl;
+			exit(1);
+		}
+		memset(counterMem, 0, thread_num * CACHELINE);
+		counterPtr = new counter_t*[thread_num];
+		ranCpu = new int[thread_num];
+		casRetries = new long[thread_num];
+		xchgSink = new uint64_t[thread_num];
+
+		for (op_type = FETCH_ADD; op_type < NUM_OP; op_type++) {
+			if (op_select != ALL_OP && op_type != op_select)
+				continue;
+			for (layout = SHARED; layout < NUM_LAYOUT; layout++) {
+				if (layout_select != ALL_LAYOUT && layout != layout_select)
+					continue;
+
+				cout<<"OpType\tLayout\t#Thread\tThroughput(Mops/sec)\tLatency(ns/op)\tRetries/op\tTime(us)\tCPUs"<<endl;
+				if (sweep_mode == SWEEP_NONE)
+					runThreadCount(thread_num);
+				else {
+					int *counts;
+					int steps = sweepThreadCounts(sweep_mode, thread_num, &counts);
+					double *rate = new double[steps];
+					for (int s = 0; s < steps; s++)
+						rate[s] = runThreadCount(counts[s]);
+					printScalingReport(counts, rate, steps, "Mops/s");
+					delete[] rate;
+					delete[] counts;
+				}
+				cout<<endl;
+			}
+		}
+
+		free(counterMem);
+		delete[] counterPtr;
+		delete[] pinCpu;
+		delete[] ranCpu;
+		delete[] casRetries;
+		delete[] xchgSink;
+
+		return 0;
+}
+
+
+
+/**
+ * point every thread at its counter for the current layout and construct the counters in place
+ * @param n thread count
+ */
+void placeCounters (int n) {
+	for (int i = 0; i < n; i++) {
+		if (layout == SHARED)
+			counterPtr[i] = (counter_t *)counterMem;
+		else if (layout == PADDED)
+			counterPtr[i] = (counter_t *)(counterMem + i * CACHELINE);
+		else
+			counterPtr[i] = (counter_t *)(counterMem + i * sizeof(counter_t));
+		new (counterPtr[i]) counter_t(0);
+	}
+}
+
+
+
+/**
+ * sum of the distinct counters, equals the number of increments after a fetch_add or CAS run
+ * @param  n thread count
+ * @return   sum of the counters
+ */
+uint64_t counterSum (int n) {
+	if (layout == SHARED)
+		return counterPtr[0]->load();
+	uint64_t sum = 0;
+	for (int i = 0; i < n; i++)
+		sum += counterPtr[i]->load();
+	return sum;
+}
+
+
+
+/**
+ * split the operations among n threads and run the benchmark repeat_num times on a pool of n workers
+ * the workers are pinned to the first n CPUs of the placement
+ * @param  n thread count
+ * @return   best throughput of the repeats, in Mops/s
+ */
+double runThreadCount (int n) {
+	thread_num = n;
+
+	opsPerThrd = new long[thread_num];
+	for (int i = 0; i < thread_num; i++)
+		opsPerThrd[i] = ops_num / thread_num + (i < ops_num % thread_num);
+	double *thrdMops = new double[thread_num];		//operations of each thread, for the per-thread report
+	for (int i = 0; i < thread_num; i++)
+		thrdMops[i] = opsPerThrd[i] / 1e6;
+
+	placeCounters(thread_num);
+	double best = 0;
+	poolCreate(thread_num, pinCpu);
+	for (int i = 0; i < repeat_num; i++) {
+		for (int j = 0; j < thread_num; j++)
+			counterPtr[j]->store(0);
+		double runtime = contention_benchmark();
+		long retries = 0;
+		if (op_type == CAS)
+			for (int j = 0; j < thread_num; j++)
+				retries += casRetries[j];
+		if (op_type != XCHG && counterSum(thread_num) != (uint64_t)ops_num)
+			cerr<<"counter check failed: "<<counterSum(thread_num)<<" increments, expected "<<ops_num<<endl;
+
+		double rate = ops_num / runtime / 1e6;
+		if (rate > best)
+			best = rate;
+		cout<<"#Iter "<<i<<"\t"<<op_name[op_type]<<"\t"<<layout_name[layout]<<"\t"<<thread_num
+			<<"\t"<<rate<<"Mops/s"
+			<<"\t"<<runtime * 1e9 / opsPerThrd[0]<<"ns\t";		//time of one operation as seen by a thread
+		if (op_type == CAS)
+			cout<<(double)retries / ops_num<<"\t";
+		else
+			cout<<"-\t";
+		cout<<runtime * 1e6<<"us\t"<<cpuListString(ranCpu, thread_num)<<endl;
+		printThreadReport(thrdMops, "Mops/s", ranCpu);
+	}
+	poolDestroy();
+
+	delete[] thrdMops;
+	delete[] opsPerThrd;
+
+	return best;
+}
+
+
+/**
+ * contention benchmark function implementation
+ * @return benchmarking time in seconds
+ */
+double contention_benchmark () {
+	//workers already exist, only barrier release to last finish is timed
+	if (op_type == FETCH_ADD)
+		return poolRun(fetchAddThread);
+	else if (op_type == CAS)
+		return poolRun(casThread);
+	else if (op_type == XCHG)
+		return poolRun(exchangeThread);
+
+	cerr<<"Invalid structions! opType can only be 0 to "<<NUM_OP - 1<<"!"<<endl;
+	abort();
+}
+
+
+/**
+ * fetch_add thread implementation, one lock xadd per operation
+ * @param  argv thread ID
+ * @return      exit current thread once it completes without being suspended
+ */
+void *fetchAddThread (void *argv) {
+	int crtThrdID = *(int *)argv;
+	counter_t *counter = counterPtr[crtThrdID];
+	for (long i = 0; i < opsPerThrd[crtThrdID]; i++)
+		counter->fetch_add(1);
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+/**
+ * CAS loop thread implementation, increments by compare-and-swap and counts the failed attempts
+ * a failed compare_exchange reloads the expected value, so every retry is one lost race for the line
+ * @param  argv thread ID
+ * @return      exit current thread once it completes without being suspended
+ */
+void *casThread (void *argv) {
+	int crtThrdID = *(int *)argv;
+	counter_t *counter = counterPtr[crtThrdID];
+	long retries = 0;		//local, the shared array is written once at the end
+	uint64_t expected = counter->load(memory_order_relaxed);
+	for (long i = 0; i < opsPerThrd[crtThrdID]; i++) {
+		while (!counter->compare_exchange_weak(expected, expected + 1))
+			retries++;
+		expected++;		//the value just stored, right unless another thread got in between
+	}
+	casRetries[crtThrdID] = retries;
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+/**
+ * exchange thread implementation, swaps in a value derived from the one it swapped out
+ * @param  argv thread ID
+ * @return      exit current thread once it completes without being suspended
+ */
+void *exchangeThread (void *argv) {
+	int crtThrdID = *(int *)argv;
+	counter_t *counter = counterPtr[crtThrdID];
+	uint64_t value = crtThrdID;
+	for (long i = 0; i < opsPerThrd[crtThrdID]; i++)
+		value = counter->exchange(value + 1);
+	xchgSink[crtThrdID] = value;
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
@@ -0,0 +1,77 @@
+#ifndef _CONTENTION_H_
+#define _CONTENTION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "affinity.h"
+#include "worker_pool.h"
+#include "scaling.h"
+
+
+#define FETCH_ADD 0		//lock xadd, never fails
+#define CAS 1			//load, then compare-and-swap until it succeeds
+#define XCHG 2			//xchg, unconditional swap
+#define NUM_OP 3
+#define ALL_OP -1		//run every operation
+
+#define SHARED 0		//every thread updates the same counter
+#define PADDED 1		//one counter per thread, each on its own cache line
+#define FALSE_SHARING 2	//one counter per thread, 8-byte counters packed next to each other
+#define NUM_LAYOUT 3
+#define ALL_LAYOUT -1	//run every layout
+
+#define CACHELINE 64L
+
+typedef int OP_TYPE;		//atomic operation
+typedef int LAYOUT;		//counter layout
+
+typedef std::atomic<uint64_t> counter_t;
+
+
+const long DEFAULTOPS = 2e7;
+
+const char* op_name[] = {"fetch_add", "CAS", "exchange"};
+const char* layout_name[] = {"shared line", "padded lines", "false sharing"};
+
+/*
+global variables
+ */
+OP_TYPE op_select = ALL_OP;		//atomic operation, default = all
+LAYOUT layout_select = ALL_LAYOUT;	//counter layout, default = all
+int thread_num = 1;		//thread num, default = 1
+bool thread_set = false;		//thread num given by the user
+SWEEP sweep_mode = SWEEP_NONE;		//thread-scaling sweep, default = single run
+long ops_num = DEFAULTOPS;		//total atomic operations of one run, split among the threads
+int repeat_num = 1;		//repeat test num, default = 1
+PLACEMENT placement = PIN_NONE;		//thread placement policy, default = unpinned
+std::string cpu_list;		//explicit CPU list for PIN_LIST
+
+OP_TYPE op_type;		//operation of the current run
+LAYOUT layout;		//layout of the current run
+
+char* counterMem;		//cache-line aligned, one line per thread
+counter_t** counterPtr;		//counter each thread updates
+long* opsPerThrd;		//atomic operations of each thread
+long* casRetries;		//failed CAS of each thread in the last run
+uint64_t* xchgSink;		//last value each thread swapped out, keeps the exchanges alive
+
+int* pinCpu;		//CPU each thread is pinned to, NULL if unpinned
+int* ranCpu;		//CPU each thread actually ran on, recorded when the thread finishes
+
+
+/*
+functions declarations
+ */
+void helper (char *arg);
+double runThreadCount (int n);
+void placeCounters (int n);
+uint64_t counterSum (int n);
+double contention_benchmark ();
+void *fetchAddThread (void *argv);
+void *casThread (void *argv);
+void *exchangeThread (void *argv);
+
+
+
+#endif
@@ -13,6 +13,11 @@
 #include <sys/time.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <sched.h>		//sched_getcpu
+#include <getopt.h>		//getopt_long
+#include <ctime>		//clock_gettime
+#include <cmath>		//fabs
+#include <algorithm>	//std::max
 #include <string>
 #include "cpu_benchmark.h"
 
@@ -25,15 +30,22 @@ using namespace std;
  */
 void helper (char *arg) {
 	cout<<arg<<": CPU benchmark tool, Version 0.0.1 (lchen96@hawk.iit.edu)"<<endl<<endl;
-	cout<<"usage:\t"<<arg<<" [-h] [-o <operation>] [-t <threads>] [-l <loops>] [-r <repeats>]"<<endl;
+	cout<<"usage:\t"<<arg<<" [-h] [-m <metric>] [-o <operation>] [-i <isa>] [-t <threads>] [-l <loops>] [-r <repeats>] [-p <placement>] [-c <cpulist>] [--sweep-threads[=linear|pow2]]"<<endl;
 	cout<<"Arguments:"<<endl;
 	cout<<"\t-h\tlist available commands"<<endl;
-	cout<<"\t-o\toperation type, DbFloat=0, Integer=1"<<endl;
+	cout<<"\t-m\tmetric, latency=0 (dependent chains, cycles per op), throughput=1 (defaulted)"<<endl;
+	cout<<"\t-o\toperation type, DbFloat=0, Integer=1, Integer suite=2 (every integer instruction, ops/cycle),"<<endl
+		<<"\t\tSgFloat=3, Int16 dot=4, Int8 dot=5 (pmaddubsw and VNNI), fp16/bf16 conversion=6"<<endl;
+	cout<<"\t-i\tinstruction set, Scalar=0, SSE2=1, AVX=2, AVX2+FMA=3, AVX-512=4 [default = every supported one]"<<endl;
 //	cout<<"\t-f\ttest double precision floating point operations (defaulted)"<<endl;
 //	cout<<"\t-i\ttest integer operatons"<<endl;
-	cout<<"\t-t\tnumber of threads ( <= "<<MAXTHREADS<<") [default = 1]"<<endl;
-	cout<<"\t-l\tnumber of loops[default = 1e^9]"<<endl;
+	cout<<"\t-t\tnumber of threads ( <= "<<onlineCpus()<<" online CPUs) [default = 1]"<<endl;
+	cout<<"\t-l\tnumber of loops[default = 8e8, latency = 1e7]"<<endl;
 	cout<<"\t-r\tnumber of repeated benchmark tests[default = 1]"<<endl;
+	cout<<"\t-p\tthread placement, compact=0, scatter=1, physical cores only=2, SMT pairs=3 [default = unpinned]"<<endl;
+	cout<<"\t-c\tpin threads to an explicit CPU list, like 0-3,8"<<endl;
+	cout<<"\t--sweep-threads\tthroughput mode only, run every thread count from 1 to -t (default: all online CPUs),"<<endl
+		<<"\t\tlinear or powers of two (defaulted), and report speedup, efficiency and the serial fraction"<<endl;
 	cout<<endl;
 }
 
@@ -44,44 +56,93 @@ int main (int argc, char *argv[]) {
 	use getopt function to parse the input arguments
 	 */
 	int c;
-	// only accepts "hfitlr" arguments, where for "tlr" the argument can be optional
-	while ((c = getopt (argc, argv, ":ho::t::l::r::")) != -1) 
+	static struct option long_options[] = {
+		{"sweep-threads", optional_argument, NULL, SWEEP_OPT},
+		{0, 0, 0, 0}
+	};
+	// only accepts "hmoitlrpc" arguments, where for "moitlrp" the argument can be optional
+	while ((c = getopt_long (argc, argv, ":hm::o::i::t::l::r::p::c:", long_options, NULL)) != -1) 
 		switch (c) {
 			case 'h':	//helper
 				helper(argv[0]);
 				exit(0);
+			case 'm':	//metric
+				metric = stoi(optarg);
+				if (metric != LTC && metric != THRPT) {
+					cerr<<"metric can only be 0 or 1!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
 			case 'o':	//operation type
-				if (stoi(optarg) == 0)
-					op_type = FLOP;
-				else if (stoi(optarg) == 1)
-					op_type = IOP;
-				else {
-					cerr<<"option type can only be 0 or 1!\n"<<endl;
+				op_type = stoi(optarg);
+				if (op_type < FLOP || op_type >= NUM_OP) {
+					cerr<<"option type can only be 0 to "<<NUM_OP - 1<<"!\n"<<endl;
 					helper(argv[0]);
 					exit(1);
 				}
 				break;
+			case 'i':	//instruction set
+				isa_select = stoi(optarg);
+				if (isa_select < ISA_SCALAR || isa_select >= NUM_ISA) {
+					cerr<<"instruction set can only be 0 to "<<NUM_ISA - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				if (!isaSupported(isa_select)) {
+					cerr<<isa_name[isa_select]<<" is not supported by this CPU!"<<endl;
+					exit(1);
+				}
+				break;
 			case 't':		//thread number
-				if ((thread_num = atoi(optarg)) > MAXTHREADS) {
-					cout<<"Exceed the supported thread limit! ( <= "<<MAXTHREADS<<")"<<endl;
+				thread_num = atoi(optarg);
+				if (thread_num < 1 || thread_num > onlineCpus()) {
+					cout<<"Thread number must be 1 to the online CPU count ("<<onlineCpus()<<")!"<<endl;
 					exit(2);
 				}
+				thread_set = true;
 				break;
 			case 'l':		//loop number, equally is the number of total operations
 				loop_num = (long)atof(optarg);	//accept exponent input like 8e9
+				loop_set = true;
 				break;
 			case 'r':	//times to repeat the benchmark 
 				repeat_num = stoi(optarg);
 				break;
+			case 'p':	//placement policy
+				placement = stoi(optarg);
+				if (placement < PIN_COMPACT || placement >= PIN_LIST) {
+					cerr<<"placement can only be 0 to "<<PIN_LIST - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'c':	//explicit CPU list
+				placement = PIN_LIST;
+				cpu_list = optarg;
+				break;
+			case SWEEP_OPT:		//thread-scaling sweep
+				if ((sweep_mode = parseSweepMode(optarg)) == -1) {
+					cerr<<"sweep can only be linear or pow2!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
 			case ':':	/*missing option argument, using default value*/
-				if (optopt == 'o') 
+				if (optopt == 'm')
+					metric = THRPT;
+				else if (optopt == 'o') 
 					op_type = FLOP;
+				else if (optopt == 'i')
+					isa_select = ALL_ISA;
 				else if (optopt == 't') 
 					thread_num = 1;
 				else if (optopt == 'l')
 					loop_num = DEFAULTLOOP;
 				else if (optopt == 'r')
 					repeat_num = 1;
+				else if (optopt == 'p')
+					placement = PIN_COMPACT;
 				break;
 			case '?':	/* invalid option*/
 			default:
@@ -91,126 +152,469 @@ int main (int argc, char *argv[]) {
 		}
 
 
+		if ((metric == LTC || op_type == INTSUITE) && !loop_set)
+			loop_num = DEFAULTCHAINLOOP;
+
+		if (sweep_mode != SWEEP_NONE) {
+			if (metric == LTC || op_type == INTSUITE) {
+				cerr<<"--sweep-threads only applies to the throughput operation types!"<<endl;
+				exit(1);
+			}
+			if (!thread_set)
+				thread_num = onlineCpus();
+		}
+
+		pinCpu = planPlacement(placement, thread_num, cpu_list);
+		if (placement != PIN_NONE && pinCpu == NULL)
+			exit(1);
+
+		freq_source = freqInit();
+
 		//output user's setting information for benchmark
 		cout<<"\nThe benchmarking begins with:"
-			<<"\n\tOperation:\t\t"<<op[op_type]
-			<<"\n\t#Thread:\t\t"<<thread_num
+			<<"\n\tMetric:\t\t\t"<<(metric == LTC ? "Latency" : "Throughput")
+			<<"\n\tOperation:\t\t"<<(metric == LTC ? "all instructions" : op_name[op_type])
+			<<"\n\tISA:\t\t\t"<<(isa_select == ALL_ISA ? "all supported" : isa_name[isa_select])
+			<<"\n\t#Thread:\t\t"<<(sweep_mode == SWEEP_NONE ? to_string(thread_num) : "sweep 1 to " + to_string(thread_num) + " (" + sweep_name[sweep_mode] + ")")
+			<<"\n\tPlacement:\t\t"<<(placement == PIN_NONE ? "unpinned" : placement_name[placement] + string(" (") + cpuListString(pinCpu, thread_num) + ")")
 			<<"\n\t#Loop:\t\t\t"<<loop_num
-			<<"\n\t#Iteration:\t\t"<<repeat_num<<endl<<endl<<endl;
+			<<"\n\t#Iteration:\t\t"<<repeat_num
+			<<"\n\tFrequency:\t\t"<<freq_source_name[freq_source];
+		if (freq_source == FREQ_MSR)
+			cout<<" (TSC "<<tscGhz()<<" GHz)";
+		else
+			cout<<" (no access to /dev/cpu/N/msr)";
+		cout<<endl<<endl<<endl;
 
 
 
-		//float *runtime = (float *) malloc (sizeof(float) * repeat_num); 
-		float *runtime = new float[repeat_num];
-		if (op_type == FLOP)
-			cout<<"CPU\tOpType\t#Thread\t#Operation\tGFLOPS\tTime"<<endl;
+		result_sink = new double[thread_num];
+		ranCpu = new int[thread_num];
+		thread_ghz = new double[thread_num];
+		probe_seconds = new double[thread_num];
+		poolCreate(thread_num, pinCpu);
+
+		if (metric == LTC)
+			latencyMode();
+		else if (op_type == INTSUITE)
+			intSuiteMode();
 		else
-			cout<<"CPU\tOpType\t#Thread\t#Operation\tGIOPS\tTime"<<endl;
+			throughputMode();
+
+		poolDestroy();
+		freqClose();
+		delete[] result_sink;
+		delete[] ranCpu;
+		delete[] thread_ghz;
+		delete[] probe_seconds;
+		delete[] pinCpu;
+		return 0;
 
-		for (int i = 0; i < repeat_num; i++) {
-			runtime[i] = cpu_benchmark();
-			cout<<"#Iter "<<i<<"\t"<<op[op_type] 
-				<<"\t"<<thread_num<<"\t"<<loop_num<<"\t"<<(loop_num * 18 / runtime[i] / 1e9)<<"\t"<<runtime[i]<<endl;
+}
 
+
+
+
+/**
+ * throughput mode: peak rate of the selected operation on every ISA level,
+ * an ISA level with several kernels of the operation (like Int8Dot and Int8VNNI) runs each one
+ * with --sweep-threads every kernel runs at each thread count of the sweep, followed by its scaling report
+ */
+void throughputMode () {
+	double peak[NUM_ISA] = {0};		//best result of each ISA level, 0 if not run
+	double peak_ghz[NUM_ISA] = {0};	//effective frequency of the best result
+	int *counts = NULL;		//thread counts of the sweep
+	int steps = 1;
+	if (sweep_mode != SWEEP_NONE)
+		steps = sweepThreadCounts(sweep_mode, thread_num, &counts);
+	double *rate = new double[steps];		//best rate of each step
+	cout<<"CPU\tISA\tOpType\t#Thread\t#Operation\t"<<op_unit[op_type]<<"\tGHz\t"<<op_cycle_unit[op_type]<<"\tTime\tCPUs"<<endl;
+
+	for (int k = 0; k < NUM_KERNELS; k++) {
+		int isa = kernels[k].isa;
+		if (kernels[k].op_type != op_type || (isa_select != ALL_ISA && isa != isa_select)
+			|| !isaSupported(isa) || !featureSupported(kernels[k].feature))
+			continue;
+		crt_kernel = &kernels[k];
+		crt_run = crt_kernel->run;
+
+		for (int s = 0; s < steps; s++) {
+			if (counts)
+				resizePool(counts[s]);
+			double ghz;
+			rate[s] = runKernel(&ghz);
+			if (rate[s] > peak[isa]) {
+				peak[isa] = rate[s];
+				peak_ghz[isa] = ghz;
+			}
 		}
-		delete[] runtime;
-		return 0;
+		if (counts)
+			printScalingReport(counts, rate, steps, op_unit[op_type]);
+	}
 
+	//peak summary, one line per ISA level supported by the host
+	//a lower GHz at a wider ISA is the frequency licence, a lower per-cycle rate is the core itself
+	cout<<endl<<"Peak "<<op_unit[op_type]<<" per ISA (GHz, "<<op_cycle_unit[op_type]<<" per core):"<<endl;
+	for (int isa = ISA_SCALAR; isa < NUM_ISA; isa++) {
+		if (!isaSupported(isa))
+			cout<<"\t"<<isa_name[isa]<<"\tnot supported"<<endl;
+		else if (peak[isa] > 0)
+			cout<<"\t"<<isa_name[isa]<<"\t"<<peak[isa]<<"\t"<<peak_ghz[isa]<<" GHz\t"
+				<<perCycle(peak[isa], peak_ghz[isa])<<endl;
+	}
+	delete[] rate;
+	delete[] counts;
 }
 
 
 
-
 /**
- * Benchmark function for testing FLOPs or IOPs
- * multiple threads involved
- * @return benchmarking time in seconds
+ * warm the current kernel up to a steady frequency, then run it repeat_num times on the current pool,
+ * one result line per repeat with the effective frequency and the per-cycle rate
+ * @param  ghz effective frequency of the best repeat
+ * @return     best aggregate rate, in units of op_unit
  */
-float cpu_benchmark() {		//return running time in seconds
-	struct timeval starttime, endtime;
-	long runtime;
-	//pthread_t *threads = (pthread_t *) malloc(sizeof(pthread_t) * thread_num);
-	pthread_t *threads = new pthread_t [thread_num];
-	if (op_type == FLOP) {		//float test
-		gettimeofday(&starttime, NULL);
-		for (int i = 0; i < thread_num; i++) {
-			pthread_create(&threads[i], NULL, doubleOPs, NULL);
+double runKernel (double *ghz) {
+	//float *runtime = (float *) malloc (sizeof(float) * repeat_num); 
+	float *runtime = new float[repeat_num];
+	double best = 0;
+	crt_loop = loop_num / thread_num;
+	warmup();
+
+	//operation count comes from the kernel definition: executed iterations x ops per iteration
+	long total_ops = crt_loop * thread_num * crt_kernel->ops_per_iter;
+	double *thread_gops = new double[thread_num];		//work per thread, for the per-thread report
+	for (int t = 0; t < thread_num; t++)
+		thread_gops[t] = crt_loop * crt_kernel->ops_per_iter / 1e9;
+	for (int i = 0; i < repeat_num; i++) {
+		runtime[i] = cpu_benchmark();
+		double rate = total_ops / runtime[i] / 1e9;
+		double run_ghz = kernelFrequency();
+		if (rate > best) {
+			best = rate;
+			*ghz = run_ghz;
 		}
-		for (int i = 0; i < thread_num; i++) {
-			pthread_join(threads[i], NULL);
+		cout<<"#Iter "<<i<<"\t"<<isa_name[crt_kernel->isa]<<"\t"<<crt_kernel->name
+			<<"\t"<<thread_num<<"\t"<<total_ops<<"\t"<<rate<<"\t"<<run_ghz<<"\t"<<perCycle(rate, run_ghz)
+			<<"\t"<<runtime[i]<<"\t"<<cpuListString(ranCpu, thread_num)<<endl;
+		printThreadReport(thread_gops, op_unit[op_type], ranCpu);
+	}
+	delete[] thread_gops;
+	delete[] runtime;
+	return best;
+}
+
+
+
+/**
+ * aggregate rate per core and cycle
+ * @param  rate aggregate rate, in units of op_unit (1e9 per second)
+ * @param  ghz  effective frequency
+ * @return      operations per cycle and core, 0 if the frequency is unknown
+ */
+double perCycle (double rate, double ghz) {
+	return ghz > 0 ? rate / ghz / thread_num : 0;
+}
+
+
+
+/**
+ * run the current kernel in short slices until the effective frequency is steady,
+ * so turbo ramp-up and the switch to an AVX frequency licence stay out of the measurement
+ * steady: WARMUP_STABLE slices in a row within WARMUP_TOLERANCE of the previous one
+ */
+void warmup () {
+	long loop = crt_loop;
+	crt_loop = WARMUP_PROBE;
+	double seconds = cpu_benchmark();
+	crt_loop = max(1L, (long)(WARMUP_PROBE * WARMUP_SLICE / seconds));	//one slice of WARMUP_SLICE seconds
+
+	double elapsed = 0, ghz = 0, last = 0;
+	int slices = 0, stable = 0;
+	while (stable < WARMUP_STABLE && elapsed < WARMUP_MAX) {
+		elapsed += cpu_benchmark();
+		ghz = kernelFrequency();
+		slices++;
+		if (last > 0 && fabs(ghz - last) <= WARMUP_TOLERANCE * last)
+			stable++;
+		else
+			stable = 0;
+		last = ghz;
+	}
+	cout<<"#Warmup\t"<<slices<<" slices\t"<<elapsed * 1e3<<"ms\t"<<ghz<<" GHz\t"
+		<<(stable >= WARMUP_STABLE ? "steady" : "NOT steady")<<endl;
+	crt_loop = loop;
+}
+
+
+
+/**
+ * effective frequency of the last run, mean over the threads
+ * FREQ_MSR: APERF/MPERF taken around the kernel by every thread
+ * FREQ_CHAIN: a short dependent add chain right after the kernel, still under its frequency licence
+ * @return GHz, 0 if no thread has a valid sample
+ */
+double kernelFrequency () {
+	double sum = 0;
+	int valid = 0;
+	for (int i = 0; i < thread_num; i++)
+		if (thread_ghz[i] > 0) {
+			sum += thread_ghz[i];
+			valid++;
 		}
-		gettimeofday(&endtime, NULL);
-	} else if (op_type == IOP) {		//integer test
-		gettimeofday(&starttime, NULL);
-		for (int i = 0; i < thread_num; i++) {
-			pthread_create(&threads[i], NULL, integerOPs, NULL);
+	return valid > 0 ? sum / valid : 0;
+}
+
+
+
+/**
+ * replace the worker pool with one of n workers, pinned to the first n CPUs of the placement
+ * placements are ordered lists, so the first n entries of the plan for N threads are the plan for n
+ * @param n thread count
+ */
+void resizePool (int n) {
+	poolDestroy();
+	thread_num = n;
+	poolCreate(n, pinCpu);
+}
+
+
+
+/**
+ * latency mode: latency and reciprocal throughput of single instructions, in cycles
+ * latency comes from one dependent chain, throughput from TPUT_CHAINS independent chains,
+ * the core clock from a dependent chain of integer adds (one cycle each)
+ */
+void latencyMode () {
+	crt_loop = loop_num / thread_num;
+	long ops = crt_loop * CHAIN_UNROLL;		//dependent ops per chain and thread
+	double ghz = calibrateClock();
+
+	cout<<"CPU\tISA\tInstr\tWidth\t#Thread\tGHz\tLatency(ns)\tLatency(cycles)\tRecipThrpt(cycles)\tOps/cycle\tCPUs"<<endl;
+	for (int isa = ISA_SCALAR; isa < NUM_ISA; isa++) {
+		if ((isa_select != ALL_ISA && isa != isa_select) || !isaSupported(isa))
+			continue;
+		warmUpIsa(isa);
+		for (int k = 0; k < num_chain_kernels[isa]; k++) {
+			const chain_kernel *kernel = &chain_kernels[isa][k];
+			for (int i = 0; i < repeat_num; i++) {
+				//cycles use the frequency of each run, wide vectors may run under a lower licence
+				crt_run = kernel->latency;
+				cpu_benchmark();
+				double latency = meanThreadSeconds() / ops;
+				double ghz_l = kernelFrequency();
+				crt_run = kernel->throughput;
+				cpu_benchmark();
+				double recip = meanThreadSeconds() / (ops * TPUT_CHAINS);
+				double ghz_t = kernelFrequency();
+				if (ghz_l <= 0 || ghz_t <= 0)
+					ghz_l = ghz_t = ghz;
+				cout<<"#Iter "<<i<<"\t"<<isa_name[isa]<<"\t"<<kernel->name<<"\t"<<kernel->width<<"x"<<kernel->lanes
+					<<"\t"<<thread_num<<"\t"<<ghz_t<<"\t"<<latency * 1e9<<"\t"<<latency * ghz_l * 1e9
+					<<"\t"<<recip * ghz_t * 1e9<<"\t"<<1 / (recip * ghz_t * 1e9)
+					<<"\t"<<cpuListString(ranCpu, thread_num)<<endl;
+			}
 		}
-		for (int i = 0; i < thread_num; i++) {
-			pthread_join(threads[i], NULL);
+	}
+}
+
+
+
+/**
+ * integer suite: throughput of every integer instruction in the chain tables, one at a time
+ * ops/cycle counts instructions per core, element ops/cycle multiplies by the lanes
+ */
+void intSuiteMode () {
+	crt_loop = loop_num / thread_num;
+	long ops = crt_loop * CHAIN_UNROLL * TPUT_CHAINS;	//independent ops per thread
+	double ghz = calibrateClock();
+
+	cout<<"CPU\tISA\tInstr\tWidth\t#Thread\tGIOPS\tGHz\tOps/cycle\tElemOps/cycle\tCPUs"<<endl;
+	for (int isa = ISA_SCALAR; isa < NUM_ISA; isa++) {
+		if ((isa_select != ALL_ISA && isa != isa_select) || !isaSupported(isa))
+			continue;
+		warmUpIsa(isa);
+		for (int k = 0; k < num_chain_kernels[isa]; k++) {
+			const chain_kernel *kernel = &chain_kernels[isa][k];
+			if (kernel->op_type != IOP)
+				continue;
+			crt_run = kernel->throughput;
+			for (int i = 0; i < repeat_num; i++) {
+				cpu_benchmark();
+				double seconds = meanThreadSeconds();
+				double run_ghz = kernelFrequency();
+				if (run_ghz <= 0)
+					run_ghz = ghz;
+				double per_cycle = ops / (seconds * run_ghz * 1e9);		//per core
+				cout<<"#Iter "<<i<<"\t"<<isa_name[isa]<<"\t"<<kernel->name<<"\t"<<kernel->width<<"x"<<kernel->lanes
+					<<"\t"<<thread_num<<"\t"<<ops * thread_num / seconds / 1e9<<"\t"<<run_ghz<<"\t"<<per_cycle
+					<<"\t"<<per_cycle * kernel->lanes<<"\t"<<cpuListString(ranCpu, thread_num)<<endl;
+			}
 		}
-		gettimeofday(&endtime, NULL);
-	} else {
-		cerr<<"Invalid structions! Only accept -f or -i!"<<endl;
-		//helper();
-		abort();
 	}
-	delete[] threads;
-	runtime = (endtime.tv_sec - starttime.tv_sec) * 1000000L + (endtime.tv_usec - starttime.tv_usec);
-	return runtime/1000000.0;	//second
+}
+
+
 
+/**
+ * warm up to the steady frequency of an ISA level with the throughput variant of its first chain kernel,
+ * the frequency licence depends on the vector width, not on the instruction
+ * @param isa ISA level
+ */
+void warmUpIsa (ISA_TYPE isa) {
+	if (num_chain_kernels[isa] == 0)
+		return;
+	crt_run = chain_kernels[isa][0].throughput;
+	cout<<"#Warmup "<<isa_name[isa]<<" ("<<chain_kernels[isa][0].name<<")"<<endl;
+	warmup();
 }
 
 
 
+/**
+ * measure the core clock with a dependent chain of integer adds, one cycle each,
+ * after warming it up to a steady frequency
+ * @return GHz, mean over the threads
+ */
+double calibrateClock () {
+	crt_loop = loop_num / thread_num;
+	crt_run = addChain_scalar;
+	warmup();
+	cpu_benchmark();
+	double ghz = crt_loop * CHAIN_UNROLL / meanThreadSeconds() / 1e9;
+	cout<<"Core clock:\t"<<ghz<<" GHz (dependent integer add chain)"<<endl<<endl;
+	return ghz;
+}
+
 
 
 /**
- * Float operation benchmark
- * @return [description]
+ * mean per-thread run time of the last pool run, without the frequency probe
+ * @return seconds
  */
- void *doubleOPs(void *arg){
- 	double factor1 = 2.0;
-	double result1 = 0.0;
+double meanThreadSeconds () {
+	const thread_time *times = poolThreadTimes();
+	double sum = 0;
+	for (int i = 0; i < thread_num; i++)
+		sum += times[i].end - times[i].start - (freq_source == FREQ_CHAIN ? probe_seconds[i] : 0);
+	return sum / thread_num;
+}
 
-	double factor2 = 3.0;
-	double result2 = 1.0;
 
-	long loop = loop_num/thread_num;
-	// one incrementation and one comparasion in loop, one float add
-	for (size_t i = 0; i < loop; i++) {
-		result1 = factor1 * 2.3 + 312.2;
-		result1 = factor1 * 3.1 + 221;
-		result1 = factor2 * 3.45 + 312;
-		result2 = factor1 * 1.2 - 2.0;
-		result2 = factor2 * 2.1 + 3.4;
-		result2 = factor1 * factor2 - 3.523;
+
+/**
+ * check at runtime whether the host can execute an ISA level
+ * __builtin_cpu_supports reads cpuid and also honours OS support (XSAVE) for AVX state
+ * @param  isa ISA level
+ * @return     true if the kernels of this level can run
+ */
+bool isaSupported (ISA_TYPE isa) {
+	__builtin_cpu_init();
+	switch (isa) {
+		case ISA_SCALAR:
+			return true;
+		case ISA_SSE2:
+			return __builtin_cpu_supports("sse2");
+		case ISA_AVX:
+			return __builtin_cpu_supports("avx");
+		case ISA_AVX2:
+			return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+				&& __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("lzcnt")
+				&& __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2");
+		case ISA_AVX512:
+			return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+				&& __builtin_cpu_supports("avx512dq");
+		default:
+			return false;
 	}
-	return NULL;
 }
 
 
 
 /**
- * Integer operation benchmark
- * @return [description]
+ * check at runtime whether the host has an extension a kernel needs on top of its ISA level
+ * @param  feature FEAT_* of the kernel
+ * @return         true if the kernel can run
  */
-void *integerOPs(void *arg) {
-	 size_t factor1 = 2;
-	size_t result1 = 1;
+bool featureSupported (int feature) {
+	__builtin_cpu_init();
+	switch (feature) {
+		case FEAT_NONE:
+			return true;
+		case FEAT_F16C:
+			return __builtin_cpu_supports("f16c");
+		case FEAT_AVXVNNI:
+			return __builtin_cpu_supports("avxvnni");
+		case FEAT_VNNI:
+			return __builtin_cpu_supports("avx512vnni");
+		case FEAT_BF16:
+			return __builtin_cpu_supports("avx512bf16");
+		default:
+			return false;
+	}
+}
+
 
-	size_t factor2 = 3;
-	size_t result2 = 4;
 
-	long loop = loop_num/thread_num;
-	// one incrementation and one comparasion in loop, one interger add
-	for (size_t i = 0; i < loop; i++) {
-		result1 = factor1 * 2 + 312;
-		result1 = factor1 * 3 + 221;
-		result1 = factor2 * 3 + 312;
-		result2 = factor1 * 1 - 2;
-		result2 = factor2 * 2 + 3;
-		result2 = factor1 * factor2 - 3;
+
+/**
+ * Benchmark function, runs the current kernel body on the persistent worker pool
+ * @return benchmarking time in seconds
+ */
+float cpu_benchmark() {		//return running time in seconds
+	//workers already exist, only barrier release to last finish is timed
+	double seconds = poolRun(kernelThread);	//second
+	if (freq_source == FREQ_CHAIN) {		//the probe runs after the kernel, its longest time is not kernel time
+		double probe = 0;
+		for (int i = 0; i < thread_num; i++)
+			probe = max(probe, probe_seconds[i]);
+		seconds -= probe;
 	}
+	return seconds;
+
+}
+
+
+
+/**
+ * benchmark thread, runs the current kernel body on its share of loops
+ * @param  arg thread ID
+ * @return      NULL
+ */
+void *kernelThread (void *arg) {
+	int crtThrdID = *(int *)arg;
+	aperf_sample before, after;
+	int cpu = sched_getcpu();
+	bool sampled = freq_source == FREQ_MSR && readAperf(cpu, &before);
+
+	//seed differs per thread and is unknown at compile time, result is stored so the loop stays live
+	result_sink[crtThrdID] = crt_run(crt_loop, 1.0 + crtThrdID);
+	ranCpu[crtThrdID] = sched_getcpu();
+
+	//a thread that migrated read the counters of two different CPUs, its sample is dropped
+	if (freq_source == FREQ_CHAIN)
+		thread_ghz[crtThrdID] = probeFrequency(crtThrdID);
+	else if (sampled && ranCpu[crtThrdID] == cpu && readAperf(cpu, &after))
+		thread_ghz[crtThrdID] = aperfGhz(before, after);
+	else
+		thread_ghz[crtThrdID] = 0;
 	return NULL;
 }
 
+
+
+/**
+ * frequency probe, times a short dependent add chain (1 cycle per add) right after the kernel,
+ * it runs inside the timed region and costs well under a millisecond
+ * @param  crtThrdID thread ID
+ * @return           GHz
+ */
+double probeFrequency (int crtThrdID) {
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+	result_sink[crtThrdID] += addChain_scalar(PROBE_LOOP, 1.0 + crtThrdID);
+	clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	probe_seconds[crtThrdID] = seconds;
+	return PROBE_LOOP * CHAIN_UNROLL / seconds / 1e9;
+}
@@ -1,24 +1,56 @@
 #ifndef _CPU_HEADER_
 #define _CPU_HEADER_
 
-#define FLOP 0
-#define IOP 1
+#include <string>
+#include "cpu_kernels.h"
+#include "affinity.h"
+#include "worker_pool.h"
+#include "scaling.h"
+#include "cpu_freq.h"
 
-typedef int OP_TYPE;
+#define ALL_ISA -1		//run every ISA level the host supports
 
 
-const int MAXTHREADS = 20;
 const long DEFAULTLOOP = 8e8;
+const long DEFAULTCHAINLOOP = 1e7;	//latency mode: x CHAIN_UNROLL dependent ops per thread
 
-const char* op[] = {"DoubleFloat", "Integer"};
+#define WARMUP_PROBE 1000		//loops of the run that sizes a warmup slice
+#define WARMUP_SLICE 0.02		//seconds per warmup slice
+#define WARMUP_TOLERANCE 0.01	//a slice is steady within 1% of the frequency of the previous one
+#define WARMUP_STABLE 3			//steady slices in a row that end the warmup
+#define WARMUP_MAX 2.0			//seconds, the warmup gives up after that
+#define PROBE_LOOP 25000		//frequency probe: x CHAIN_UNROLL dependent adds, about 0.1ms
+
+const char* isa_name[] = {"Scalar", "SSE2", "AVX", "AVX2+FMA", "AVX-512"};
+const char* op_name[] = {"DoubleFloat", "Integer", "Integer suite", "SingleFloat", "Int16Dot", "Int8Dot", "HalfConvert"};
+const char* op_unit[] = {"GFLOPS", "GIOPS", "Ops/cycle", "GFLOPS", "GIOPS", "GIOPS", "GElem/s"};	//per element
+const char* op_cycle_unit[] = {"FLOPs/cycle", "IOPs/cycle", "Ops/cycle", "FLOPs/cycle", "IOPs/cycle", "IOPs/cycle", "Elem/cycle"};	//per core
 
 /*
 * global variables
  */
-OP_TYPE op_type = FLOP;		//opeartion type: float or integer, default = float
+OP_TYPE op_type = FLOP;		//opeartion type, see op_name, default = double float
+METRIC metric = THRPT;		//peak throughput or instruction latency, default = throughput
+ISA_TYPE isa_select = ALL_ISA;	//instruction set to benchmark, default = every supported one
 int thread_num = 1;		//thread num, default = 1
+bool thread_set = false;		//thread num given by the user
+SWEEP sweep_mode = SWEEP_NONE;	//thread-scaling sweep, default = single run
 long loop_num = DEFAULTLOOP;		//loop num, default = 8e9
+bool loop_set = false;		//loop num given by the user
 int repeat_num = 1;		//repeat test num, defeault = 1
+PLACEMENT placement = PIN_NONE;	//thread placement policy, default = unpinned
+std::string cpu_list;		//explicit CPU list for PIN_LIST
+
+int *pinCpu;		//CPU each thread is pinned to, NULL if unpinned
+int *ranCpu;		//CPU each thread actually ran on, recorded at the end of the kernel
+
+const cpu_kernel *crt_kernel;	//kernel of the current throughput run
+double (*crt_run)(long loop, double seed);	//kernel body run by the benchmark threads
+long crt_loop;		//iterations per thread of the current run
+double *result_sink;		//kernel result of each thread, keeps the computation alive
+FREQ_SOURCE freq_source;		//where the effective frequency comes from
+double *thread_ghz;		//effective frequency of each thread during the last run, 0 if unknown
+double *probe_seconds;		//time of each thread in the frequency probe of the last run, FREQ_CHAIN only
 
 
 
@@ -26,9 +58,65 @@ int repeat_num = 1;		//repeat test num, defeault = 1
 * functions
  */
 void helper (char *arg);
+bool isaSupported (ISA_TYPE isa);
+bool featureSupported (int feature);
 float cpu_benchmark ();
-void *doubleOPs (void *arg);
-void *integerOPs (void *arg);
+void throughputMode ();
+double runKernel (double *ghz);
+double perCycle (double rate, double ghz);
+void warmup ();
+void warmUpIsa (ISA_TYPE isa);
+double kernelFrequency ();
+void resizePool (int n);
+void latencyMode ();
+void intSuiteMode ();
+double calibrateClock ();
+double meanThreadSeconds ();
+void *kernelThread (void *arg);
+double probeFrequency (int crtThrdID);
+
+
+/*
+* kernel table, an ISA level may carry several kernels of one operation type
+* DoubleFloat, SingleFloat: one multiply and one add (or one FMA) per chain and lane
+* Integer: one multiply and one add per chain and lane
+* Int16Dot, Int8Dot: one multiply and one add per input element, whatever the instruction sequence
+* HalfConvert: one narrowing and one widening conversion per element
+ */
+const cpu_kernel kernels[] = {
+	{"DoubleFloat", ISA_SCALAR, FLOP, FLOP_CHAINS * 2, doubleOPs_scalar},
+	{"Integer", ISA_SCALAR, IOP, IOP_CHAINS * 2, integerOPs_scalar},
+	{"DoubleFloat", ISA_SSE2, FLOP, FLOP_CHAINS * 2 * 2, doubleOPs_sse2},
+	{"Integer", ISA_SSE2, IOP, IOP_CHAINS * 2 * 2, integerOPs_sse2},
+	{"DoubleFloat", ISA_AVX, FLOP, FLOP_CHAINS * 2 * 4, doubleOPs_avx},
+	{"Integer", ISA_AVX, IOP, IOP_CHAINS * 2 * 4, integerOPs_avx},
+	{"DoubleFloat", ISA_AVX2, FLOP, FLOP_CHAINS * 2 * 4, doubleOPs_avx2},
+	{"Integer", ISA_AVX2, IOP, IOP_CHAINS * 2 * 8, integerOPs_avx2},
+	{"DoubleFloat", ISA_AVX512, FLOP, FLOP_CHAINS * 2 * 8, doubleOPs_avx512},
+	{"Integer", ISA_AVX512, IOP, IOP_CHAINS * 2 * 16, integerOPs_avx512},
+	{"SingleFloat", ISA_SCALAR, SPFLOP, FLOP_CHAINS * 2, floatOPs_scalar},
+	{"SingleFloat", ISA_SSE2, SPFLOP, FLOP_CHAINS * 2 * 4, floatOPs_sse2},
+	{"SingleFloat", ISA_AVX, SPFLOP, FLOP_CHAINS * 2 * 8, floatOPs_avx},
+	{"SingleFloat", ISA_AVX2, SPFLOP, FLOP_CHAINS * 2 * 8, floatOPs_avx2},
+	{"SingleFloat", ISA_AVX512, SPFLOP, FLOP_CHAINS * 2 * 16, floatOPs_avx512},
+	{"Int16Dot", ISA_SSE2, DOT16, DOT_CHAINS * 2 * 8, dot16OPs_sse2},
+	{"Int16Dot", ISA_AVX2, DOT16, DOT_CHAINS * 2 * 16, dot16OPs_avx2},
+	{"Int16Dot", ISA_AVX512, DOT16, DOT_CHAINS * 2 * 32, dot16OPs_avx512},
+	{"Int8Dot", ISA_AVX2, DOT8, DOT_CHAINS * 2 * 32, dot8OPs_avx2},
+	{"Int8VNNI", ISA_AVX2, DOT8, DOT_CHAINS * 2 * 32, dot8VNNI_avx2, FEAT_AVXVNNI},
+	{"Int8Dot", ISA_AVX512, DOT8, DOT_CHAINS * 2 * 64, dot8OPs_avx512},
+	{"Int8VNNI", ISA_AVX512, DOT8, DOT_CHAINS * 2 * 64, dot8VNNI_avx512, FEAT_VNNI},
+	{"FP16Cvt", ISA_AVX2, HALFCVT, FLOP_CHAINS * 2 * 8, fp16Cvt_avx2, FEAT_F16C},
+	{"FP16Cvt", ISA_AVX512, HALFCVT, FLOP_CHAINS * 2 * 16, fp16Cvt_avx512},
+	{"BF16Cvt", ISA_AVX512, HALFCVT, FLOP_CHAINS * 2 * 16, bf16Cvt_avx512, FEAT_BF16},
+};
+const int NUM_KERNELS = sizeof(kernels) / sizeof(kernels[0]);
+
+/*
+* latency/throughput kernel tables, indexed by ISA
+ */
+const chain_kernel *chain_kernels[] = {chain_kernels_scalar, chain_kernels_sse2, chain_kernels_avx, chain_kernels_avx2, chain_kernels_avx512};
+const int num_chain_kernels[] = {num_chain_kernels_scalar, num_chain_kernels_sse2, num_chain_kernels_avx, num_chain_kernels_avx2, num_chain_kernels_avx512};
 
 
 
@@ -0,0 +1,113 @@
+/**
+ * @file cpu_freq.cpp
+ * effective core frequency from the APERF/MPERF MSRs
+ *
+ * the msr device of every CPU is opened once at startup, so a worker only issues two preads per run
+ * the TSC rate is measured against CLOCK_MONOTONIC_RAW, MPERF counts at that rate while the core is in C0
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <string>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>		//sched_getcpu
+#include <x86intrin.h>		//__rdtsc
+#include "cpu_freq.h"
+
+using namespace std;
+
+
+#define TSC_CALIBRATION 0.05	//seconds of the TSC rate measurement
+
+const char* freq_source_name[] = {"TSC x APERF/MPERF", "dependent add chain after each run"};
+
+static int *msrFd = NULL;		//open /dev/cpu/N/msr of each configured CPU, -1 if unavailable
+static int msrCount = 0;
+static double tsc_ghz = 0;
+
+
+
+/**
+ * open the msr device of every CPU and measure the TSC rate
+ * @return FREQ_MSR if APERF/MPERF can be read and advance, FREQ_CHAIN otherwise
+ */
+FREQ_SOURCE freqInit () {
+	msrCount = sysconf(_SC_NPROCESSORS_CONF);
+	msrFd = new int[msrCount];
+	for (int i = 0; i < msrCount; i++)
+		msrFd[i] = open(("/dev/cpu/" + to_string(i) + "/msr").c_str(), O_RDONLY);
+
+	//the counters must exist and tick, some hypervisors expose the msr device without them
+	aperf_sample a, b;
+	int cpu = sched_getcpu();
+	if (!readAperf(cpu, &a) || !readAperf(cpu, &b) || b.mperf == a.mperf) {
+		freqClose();
+		return FREQ_CHAIN;
+	}
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+	unsigned long long c0 = __rdtsc();
+	do
+		clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+	while ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9 < TSC_CALIBRATION);
+	unsigned long long c1 = __rdtsc();
+	tsc_ghz = (c1 - c0) / ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9) / 1e9;
+	return FREQ_MSR;
+}
+
+
+
+/**
+ * TSC rate measured by freqInit
+ * @return GHz, 0 if the MSRs are not used
+ */
+double tscGhz () {
+	return tsc_ghz;
+}
+
+
+
+/**
+ * read APERF and MPERF of one CPU, the calling thread should run on that CPU
+ * @param  cpu    logical CPU id
+ * @param  sample output
+ * @return        true on success
+ */
+bool readAperf (int cpu, aperf_sample *sample) {
+	if (msrFd == NULL || cpu < 0 || cpu >= msrCount || msrFd[cpu] < 0)
+		return false;
+	return pread(msrFd[cpu], &sample->aperf, sizeof(sample->aperf), MSR_APERF) == sizeof(sample->aperf)
+		&& pread(msrFd[cpu], &sample->mperf, sizeof(sample->mperf), MSR_MPERF) == sizeof(sample->mperf);
+}
+
+
+
+/**
+ * effective frequency between two samples of the same CPU
+ * @param  before sample taken before the work
+ * @param  after  sample taken after the work
+ * @return        GHz, 0 if MPERF did not advance
+ */
+double aperfGhz (const aperf_sample &before, const aperf_sample &after) {
+	if (after.mperf == before.mperf)
+		return 0;
+	return tsc_ghz * (double)(after.aperf - before.aperf) / (after.mperf - before.mperf);
+}
+
+
+
+/**
+ * close the msr devices
+ */
+void freqClose () {
+	for (int i = 0; i < msrCount; i++)
+		if (msrFd[i] >= 0)
+			close(msrFd[i]);
+	delete[] msrFd;
+	msrFd = NULL;
+	msrCount = 0;
+}
@@ -0,0 +1,42 @@
+#ifndef _CPU_FREQ_H_
+#define _CPU_FREQ_H_
+
+/*
+* effective core frequency of the benchmark threads
+* preferred source: APERF/MPERF from /dev/cpu/N/msr (needs the msr module and root),
+* MPERF ticks at the TSC rate and APERF at the actual clock, so GHz = TSC GHz x dAPERF / dMPERF
+* fallback: a short dependent add chain (1 cycle per add) run right after the kernel,
+* while the core still holds the frequency licence the kernel put it in
+ */
+
+#define FREQ_MSR 0		//TSC x APERF/MPERF
+#define FREQ_CHAIN 1	//dependent add chain after each run
+
+#define MSR_MPERF 0xE7
+#define MSR_APERF 0xE8
+
+typedef int FREQ_SOURCE;	//frequency source
+
+extern const char* freq_source_name[];
+
+
+/*
+* APERF/MPERF counters of one CPU at one point in time
+ */
+typedef struct {
+	unsigned long long aperf;
+	unsigned long long mperf;
+} aperf_sample;
+
+
+/*
+* functions declarations
+ */
+FREQ_SOURCE freqInit ();
+double tscGhz ();
+bool readAperf (int cpu, aperf_sample *sample);
+double aperfGhz (const aperf_sample &before, const aperf_sample &after);
+void freqClose ();
+
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef _CPU_KERNELS_H_
+#define _CPU_KERNELS_H_
+
+/*
+* kernel catalogue shared by cpu_benchmark and the per-ISA kernel files
+* each cpu_kernels_<isa>.cpp is compiled with its own -m flags,
+* cpu_benchmark only calls a variant after checking cpuid at runtime
+ */
+
+#define FLOP 0		//double precision multiply-add
+#define IOP 1		//integer multiply-add
+#define INTSUITE 2	//every integer instruction of the chain tables, not a cpu_kernel
+#define SPFLOP 3	//single precision multiply-add
+#define DOT16 4		//int16 dot product, pmaddwd
+#define DOT8 5		//int8 dot product, pmaddubsw or VNNI vpdpbusd
+#define HALFCVT 6	//fp32 <-> fp16/bf16 conversion
+#define NUM_OP 7
+
+#define FEAT_NONE 0		//ISA level is enough
+#define FEAT_F16C 1		//fp16 conversion, 256-bit
+#define FEAT_AVXVNNI 2	//VEX encoded VNNI, 256-bit
+#define FEAT_VNNI 3		//AVX-512 VNNI
+#define FEAT_BF16 4		//AVX-512 BF16
+
+#define ISA_SCALAR 0
+#define ISA_SSE2 1
+#define ISA_AVX 2
+#define ISA_AVX2 3		//AVX2 + FMA, with POPCNT/LZCNT/BMI1/BMI2
+#define ISA_AVX512 4	//AVX-512 F/BW/DQ
+#define NUM_ISA 5
+
+#define FLOP_CHAINS 12		//independent FP accumulator chains, covers 2 FMA pipes x 4-6 cycle latency
+#define IOP_CHAINS 8		//independent integer accumulator chains, covers 1 mul pipe x 3-10 cycle latency
+#define DOT_CHAINS 6		//independent dot-product accumulators, inputs are per chain too, fits 16 registers
+
+#define LTC 0		//latency: one dependent chain
+#define THRPT 1		//throughput: independent chains
+
+#define CHAIN_UNROLL 8		//dependent steps per chain and loop iteration, hides the loop overhead
+#define TPUT_CHAINS 12		//independent chains of the throughput variant, enough for 4 pipes x 3 cycles
+
+typedef int OP_TYPE;
+typedef int ISA_TYPE;
+typedef int METRIC;
+
+
+/*
+* kernel definition
+* each kernel runs "loop" iterations over several independent chains
+* and returns a value folded from every chain, so no work can be eliminated
+ */
+typedef struct {
+	const char* name;		//name printed in the report
+	ISA_TYPE isa;			//instruction set the kernel is compiled for
+	OP_TYPE op_type;		//FLOP, IOP, SPFLOP, DOT16, DOT8 or HALFCVT
+	long ops_per_iter;		//operations per loop iteration, counted per element from the kernel body
+	double (*run)(long loop, double seed);	//kernel body
+	int feature;			//extension needed on top of the ISA level, FEAT_NONE if omitted
+} cpu_kernel;
+
+
+/*
+* latency/throughput kernel pair of one instruction
+* latency runs a single dependent chain, throughput TPUT_CHAINS independent ones,
+* both execute CHAIN_UNROLL steps per chain and loop iteration
+ */
+typedef struct {
+	const char* name;		//instruction, like "add" or "fma"
+	ISA_TYPE isa;			//instruction set the kernel is compiled for
+	OP_TYPE op_type;		//FLOP or IOP
+	int width;				//lane width in bits
+	int lanes;				//lanes per instruction, 1 for scalar
+	double (*latency)(long loop, double seed);
+	double (*throughput)(long loop, double seed);
+} chain_kernel;
+
+
+/*
+* generic body of the latency/throughput kernels
+* OP provides: type, constant(), init(seed, chain), step(x, c), opaque(x), fold(x)
+* opaque() is an empty asm statement that hides a value from the optimiser,
+* so dependent steps are neither folded (x*c*c -> x*(c*c)) nor hoisted out of the loop
+ */
+template <class OP, int CHAINS>
+double runChains (long loop, double seed) {
+	typename OP::type c = OP::constant();
+	typename OP::type acc[CHAINS];
+	OP::opaque(c);
+#pragma GCC unroll 16
+	for (int k = 0; k < CHAINS; k++)
+		acc[k] = OP::init(seed, k);
+
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 8
+		for (int u = 0; u < CHAIN_UNROLL; u++) {
+#pragma GCC unroll 16
+			for (int k = 0; k < CHAINS; k++) {
+				acc[k] = OP::step(acc[k], c);
+				OP::opaque(acc[k]);
+			}
+		}
+	}
+
+	double result = 0;
+#pragma GCC unroll 16
+	for (int k = 0; k < CHAINS; k++)
+		result += OP::fold(acc[k]);
+	return result;
+}
+
+
+/*
+* kernel bodies of each ISA
+ */
+double doubleOPs_scalar (long loop, double seed);
+double integerOPs_scalar (long loop, double seed);
+double floatOPs_scalar (long loop, double seed);
+double doubleOPs_sse2 (long loop, double seed);
+double integerOPs_sse2 (long loop, double seed);
+double floatOPs_sse2 (long loop, double seed);
+double dot16OPs_sse2 (long loop, double seed);
+double doubleOPs_avx (long loop, double seed);
+double integerOPs_avx (long loop, double seed);
+double floatOPs_avx (long loop, double seed);
+double doubleOPs_avx2 (long loop, double seed);
+double integerOPs_avx2 (long loop, double seed);
+double floatOPs_avx2 (long loop, double seed);
+double dot16OPs_avx2 (long loop, double seed);
+double dot8OPs_avx2 (long loop, double seed);
+double dot8VNNI_avx2 (long loop, double seed);		//FEAT_AVXVNNI
+double fp16Cvt_avx2 (long loop, double seed);		//FEAT_F16C
+double doubleOPs_avx512 (long loop, double seed);
+double integerOPs_avx512 (long loop, double seed);
+double floatOPs_avx512 (long loop, double seed);
+double dot16OPs_avx512 (long loop, double seed);
+double dot8OPs_avx512 (long loop, double seed);
+double dot8VNNI_avx512 (long loop, double seed);	//FEAT_VNNI
+double fp16Cvt_avx512 (long loop, double seed);
+double bf16Cvt_avx512 (long loop, double seed);		//FEAT_BF16
+
+
+/*
+* latency/throughput kernels of each ISA
+ */
+extern const chain_kernel chain_kernels_scalar[];
+extern const chain_kernel chain_kernels_sse2[];
+extern const chain_kernel chain_kernels_avx[];
+extern const chain_kernel chain_kernels_avx2[];
+extern const chain_kernel chain_kernels_avx512[];
+extern const int num_chain_kernels_scalar;
+extern const int num_chain_kernels_sse2;
+extern const int num_chain_kernels_avx;
+extern const int num_chain_kernels_avx2;
+extern const int num_chain_kernels_avx512;
+
+double addChain_scalar (long loop, double seed);	//dependent 64-bit integer adds, 1 cycle each, used as clock reference
+
+
+#endif
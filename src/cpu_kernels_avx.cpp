@@ -0,0 +1,152 @@
+/**
+ * @file cpu_kernels_avx.cpp
+ * cpu benchmark kernels, AVX (256-bit FP, 128-bit integer)
+ * built with -mavx, only called when cpuid reports AVX
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <immintrin.h>
+#include "cpu_kernels.h"
+
+
+
+/**
+ * Float operation benchmark
+ * FLOP_CHAINS independent __m256d multiply-add chains, so the FP pipes never wait on a previous result.
+ * acc = acc * 0.9999999 + 1e-7 converges to 1.0, the chains neither overflow nor go denormal.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+double doubleOPs_avx (long loop, double seed) {
+	const __m256d mul = _mm256_set1_pd(0.9999999);
+	const __m256d add = _mm256_set1_pd(1e-7);
+	__m256d acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm256_set_pd(seed, seed + 0.1 * c, seed + 0.2 * c, seed + 0.3 * c);
+
+	// FLOP_CHAINS chains x (one mul + one add) x 4 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++)
+			acc[c] = _mm256_add_pd(_mm256_mul_pd(acc[c], mul), add);
+	}
+
+	__m256d sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm256_add_pd(sum, acc[c]);
+	double lanes[4];
+	_mm256_storeu_pd(lanes, sum);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+
+
+/**
+ * Integer operation benchmark
+ * IOP_CHAINS independent __m128i 32-bit multiply-add chains (LCG steps).
+ * _mm_mullo_epi32 multiplies all four lanes, _mm_mul_epi32 only touched lanes 0 and 2.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      xor of all chains and lanes
+ */
+double integerOPs_avx (long loop, double seed) {
+	const __m128i mul = _mm_set1_epi32(1664525);
+	const __m128i add = _mm_set1_epi32(1013904223);
+	__m128i acc[IOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < IOP_CHAINS; c++)
+		acc[c] = _mm_set_epi32((int)seed, (int)seed + c, (int)seed + 2 * c, (int)seed + 3 * c);
+
+	// IOP_CHAINS chains x (one mul + one add) x 4 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < IOP_CHAINS; c++)
+			acc[c] = _mm_add_epi32(_mm_mullo_epi32(acc[c], mul), add);
+	}
+
+	__m128i sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < IOP_CHAINS; c++)
+		sum = _mm_xor_si128(sum, acc[c]);
+	int lanes[4];
+	_mm_storeu_si128((__m128i *)lanes, sum);
+	return (double)(lanes[0] ^ lanes[1] ^ lanes[2] ^ lanes[3]);
+}
+
+
+
+/**
+ * Single precision float operation benchmark
+ * FLOP_CHAINS independent __m256 multiply-add chains.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+double floatOPs_avx (long loop, double seed) {
+	const __m256 mul = _mm256_set1_ps(0.9999999f);
+	const __m256 add = _mm256_set1_ps(1e-7f);
+	__m256 acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm256_set_ps(seed, seed + 0.1f * c, seed + 0.2f * c, seed + 0.3f * c,
+			seed + 0.4f * c, seed + 0.5f * c, seed + 0.6f * c, seed + 0.7f * c);
+
+	// FLOP_CHAINS chains x (one mul + one add) x 8 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++)
+			acc[c] = _mm256_add_ps(_mm256_mul_ps(acc[c], mul), add);
+	}
+
+	__m256 sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm256_add_ps(sum, acc[c]);
+	float lanes[8];
+	_mm256_storeu_ps(lanes, sum);
+	float folded = 0;
+	for (int l = 0; l < 8; l++)
+		folded += lanes[l];
+	return folded;
+}
+
+
+
+/*
+* latency/throughput chain operations, see runChains in cpu_kernels.h
+ */
+struct addpdOp {
+	typedef __m256d type;
+	static __m256d constant () { return _mm256_set1_pd(1.0); }
+	static __m256d init (double seed, int k) { return _mm256_set_pd(seed + k, seed + k + 0.25, seed + k + 0.5, seed + k + 0.75); }
+	static __m256d step (__m256d x, __m256d c) { return _mm256_add_pd(x, c); }
+	static void opaque (__m256d &x) { __asm__ volatile ("" : "+x" (x)); }
+	static double fold (__m256d x) { return _mm256_cvtsd_f64(x); }
+};
+
+struct mulpdOp : addpdOp {
+	static __m256d step (__m256d x, __m256d c) { return _mm256_mul_pd(x, c); }
+};
+
+struct divpdOp : addpdOp {	//x alternates between x0 and 1/x0
+	static __m256d step (__m256d x, __m256d c) { return _mm256_div_pd(c, x); }
+};
+
+struct sqrtpdOp : addpdOp {
+	static __m256d init (double seed, int k) { return _mm256_set_pd(seed + k + 1.5, seed + k + 2.5, seed + k + 3.5, seed + k + 4.5); }
+	static __m256d step (__m256d x, __m256d c) { return _mm256_sqrt_pd(x); }
+};
+
+
+extern const chain_kernel chain_kernels_avx[] = {
+	{"vaddpd", ISA_AVX, FLOP, 64, 4, runChains<addpdOp, 1>, runChains<addpdOp, TPUT_CHAINS>},
+	{"vmulpd", ISA_AVX, FLOP, 64, 4, runChains<mulpdOp, 1>, runChains<mulpdOp, TPUT_CHAINS>},
+	{"vdivpd", ISA_AVX, FLOP, 64, 4, runChains<divpdOp, 1>, runChains<divpdOp, TPUT_CHAINS>},
+	{"vsqrtpd", ISA_AVX, FLOP, 64, 4, runChains<sqrtpdOp, 1>, runChains<sqrtpdOp, TPUT_CHAINS>},
+};
+extern const int num_chain_kernels_avx = sizeof(chain_kernels_avx) / sizeof(chain_kernels_avx[0]);
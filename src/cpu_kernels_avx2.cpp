@@ -0,0 +1,347 @@
+/**
+ * @file cpu_kernels_avx2.cpp
+ * cpu benchmark kernels, AVX2 + FMA (256-bit) and the scalar bit-manipulation
+ * instructions that ship with it (POPCNT, LZCNT, BMI1, BMI2)
+ * built with -mavx2 -mfma -mpopcnt -mlzcnt -mbmi -mbmi2, only called when cpuid reports all of them
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <immintrin.h>
+#include "cpu_kernels.h"
+
+
+
+/**
+ * Float operation benchmark
+ * FLOP_CHAINS independent __m256d FMA chains, one fused multiply-add counts as two operations.
+ * acc = acc * 0.9999999 + 1e-7 converges to 1.0, the chains neither overflow nor go denormal.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+double doubleOPs_avx2 (long loop, double seed) {
+	const __m256d mul = _mm256_set1_pd(0.9999999);
+	const __m256d add = _mm256_set1_pd(1e-7);
+	__m256d acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm256_set_pd(seed, seed + 0.1 * c, seed + 0.2 * c, seed + 0.3 * c);
+
+	// FLOP_CHAINS chains x (one FMA = mul + add) x 4 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++)
+			acc[c] = _mm256_fmadd_pd(acc[c], mul, add);
+	}
+
+	__m256d sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm256_add_pd(sum, acc[c]);
+	double lanes[4];
+	_mm256_storeu_pd(lanes, sum);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+
+
+/**
+ * Integer operation benchmark
+ * IOP_CHAINS independent __m256i 32-bit multiply-add chains (LCG steps).
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      xor of all chains and lanes
+ */
+double integerOPs_avx2 (long loop, double seed) {
+	const __m256i mul = _mm256_set1_epi32(1664525);
+	const __m256i add = _mm256_set1_epi32(1013904223);
+	__m256i acc[IOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < IOP_CHAINS; c++)
+		acc[c] = _mm256_set_epi32((int)seed, (int)seed + c, (int)seed + 2 * c, (int)seed + 3 * c,
+			(int)seed + 4 * c, (int)seed + 5 * c, (int)seed + 6 * c, (int)seed + 7 * c);
+
+	// IOP_CHAINS chains x (one mul + one add) x 8 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < IOP_CHAINS; c++)
+			acc[c] = _mm256_add_epi32(_mm256_mullo_epi32(acc[c], mul), add);
+	}
+
+	__m256i sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < IOP_CHAINS; c++)
+		sum = _mm256_xor_si256(sum, acc[c]);
+	int lanes[8];
+	_mm256_storeu_si256((__m256i *)lanes, sum);
+	int folded = 0;
+	for (int l = 0; l < 8; l++)
+		folded ^= lanes[l];
+	return (double)folded;
+}
+
+
+
+/**
+ * Single precision float operation benchmark
+ * FLOP_CHAINS independent __m256 FMA chains, one fused multiply-add counts as two operations.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+double floatOPs_avx2 (long loop, double seed) {
+	const __m256 mul = _mm256_set1_ps(0.9999999f);
+	const __m256 add = _mm256_set1_ps(1e-7f);
+	__m256 acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm256_set_ps(seed, seed + 0.1f * c, seed + 0.2f * c, seed + 0.3f * c,
+			seed + 0.4f * c, seed + 0.5f * c, seed + 0.6f * c, seed + 0.7f * c);
+
+	// FLOP_CHAINS chains x (one FMA = mul + add) x 8 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++)
+			acc[c] = _mm256_fmadd_ps(acc[c], mul, add);
+	}
+
+	__m256 sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm256_add_ps(sum, acc[c]);
+	float lanes[8];
+	_mm256_storeu_ps(lanes, sum);
+	float folded = 0;
+	for (int l = 0; l < 8; l++)
+		folded += lanes[l];
+	return folded;
+}
+
+
+
+/**
+ * xor-fold the accumulators of a dot-product kernel
+ * @param  acc DOT_CHAINS accumulators
+ * @return     xor of all accumulators and lanes
+ */
+static double foldDot (const __m256i *acc) {
+	__m256i sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < DOT_CHAINS; c++)
+		sum = _mm256_xor_si256(sum, acc[c]);
+	int lanes[8];
+	_mm256_storeu_si256((__m256i *)lanes, sum);
+	int folded = 0;
+	for (int l = 0; l < 8; l++)
+		folded ^= lanes[l];
+	return (double)folded;
+}
+
+
+
+/**
+ * Int16 dot product benchmark
+ * DOT_CHAINS independent 32-bit accumulators fed by vpmaddwd, see dot16OPs_sse2.
+ * @param  loop number of iterations
+ * @param  seed initial value of the inputs
+ * @return      xor of all accumulators and lanes
+ */
+double dot16OPs_avx2 (long loop, double seed) {
+	const __m256i w = _mm256_set1_epi16(3);
+	__m256i in[DOT_CHAINS], acc[DOT_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < DOT_CHAINS; c++) {
+		in[c] = _mm256_set1_epi16((short)seed + c);
+		acc[c] = _mm256_setzero_si256();
+	}
+
+	// DOT_CHAINS chains x (one mul + one add) x 16 int16 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < DOT_CHAINS; c++) {
+			__asm__ volatile ("" : "+x" (in[c]));
+			acc[c] = _mm256_add_epi32(acc[c], _mm256_madd_epi16(in[c], w));
+		}
+	}
+	return foldDot(acc);
+}
+
+
+
+/**
+ * Int8 dot product benchmark, pre-VNNI sequence
+ * vpmaddubsw (u8 x s8 -> pairwise s16), vpmaddwd with ones (-> s32), vpaddd into the accumulator.
+ * 2 ops per int8 element, whatever the number of instructions it takes.
+ * @param  loop number of iterations
+ * @param  seed initial value of the inputs
+ * @return      xor of all accumulators and lanes
+ */
+double dot8OPs_avx2 (long loop, double seed) {
+	const __m256i w = _mm256_set1_epi8(3);
+	const __m256i ones = _mm256_set1_epi16(1);
+	__m256i in[DOT_CHAINS], acc[DOT_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < DOT_CHAINS; c++) {
+		in[c] = _mm256_set1_epi8((char)seed + c);
+		acc[c] = _mm256_setzero_si256();
+	}
+
+	// DOT_CHAINS chains x (one mul + one add) x 32 int8 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < DOT_CHAINS; c++) {
+			__asm__ volatile ("" : "+x" (in[c]));
+			acc[c] = _mm256_add_epi32(acc[c], _mm256_madd_epi16(_mm256_maddubs_epi16(in[c], w), ones));
+		}
+	}
+	return foldDot(acc);
+}
+
+
+
+/**
+ * Int8 dot product benchmark, AVX-VNNI
+ * one vpdpbusd per chain does the whole u8 x s8 -> s32 multiply-accumulate.
+ * Compiled for avxvnni on this function only, called when cpuid reports it.
+ * @param  loop number of iterations
+ * @param  seed initial value of the inputs
+ * @return      xor of all accumulators and lanes
+ */
+__attribute__((target("avxvnni")))
+double dot8VNNI_avx2 (long loop, double seed) {
+	const __m256i w = _mm256_set1_epi8(3);
+	__m256i in[DOT_CHAINS], acc[DOT_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < DOT_CHAINS; c++) {
+		in[c] = _mm256_set1_epi8((char)seed + c);
+		acc[c] = _mm256_setzero_si256();
+	}
+
+	// DOT_CHAINS chains x (one mul + one add) x 32 int8 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < DOT_CHAINS; c++) {
+			__asm__ volatile ("" : "+x" (in[c]));
+			acc[c] = _mm256_dpbusd_avx_epi32(acc[c], in[c], w);
+		}
+	}
+	return foldDot(acc);
+}
+
+
+
+/**
+ * fp16 conversion benchmark, F16C
+ * FLOP_CHAINS chains of fp32 -> fp16 -> fp32 round trips (vcvtps2ph + vcvtph2ps),
+ * one conversion counts as one op per element. A round trip of a normal value is stable.
+ * Compiled for f16c on this function only, called when cpuid reports it.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+__attribute__((target("f16c")))
+double fp16Cvt_avx2 (long loop, double seed) {
+	__m256 acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm256_set1_ps(seed + 0.5f * c);
+
+	// FLOP_CHAINS chains x 2 conversions x 8 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++)
+			acc[c] = _mm256_cvtph_ps(_mm256_cvtps_ph(acc[c], _MM_FROUND_TO_NEAREST_INT));
+	}
+
+	__m256 sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm256_add_ps(sum, acc[c]);
+	float lanes[8];
+	_mm256_storeu_ps(lanes, sum);
+	return lanes[0];
+}
+
+
+
+/*
+* latency/throughput chain operations, see runChains in cpu_kernels.h
+ */
+struct fmasdOp {	//scalar FMA, x = x * 1.0 + 1.0
+	typedef __m128d type;
+	static __m128d constant () { return _mm_set1_pd(1.0); }
+	static __m128d init (double seed, int k) { return _mm_set_sd(seed + k); }
+	static __m128d step (__m128d x, __m128d c) { return _mm_fmadd_sd(x, c, c); }
+	static void opaque (__m128d &x) { __asm__ volatile ("" : "+x" (x)); }
+	static double fold (__m128d x) { return _mm_cvtsd_f64(x); }
+};
+
+struct fmapdOp {	//x = x * 1.0 + 1.0 on four lanes
+	typedef __m256d type;
+	static __m256d constant () { return _mm256_set1_pd(1.0); }
+	static __m256d init (double seed, int k) { return _mm256_set_pd(seed + k, seed + k + 0.25, seed + k + 0.5, seed + k + 0.75); }
+	static __m256d step (__m256d x, __m256d c) { return _mm256_fmadd_pd(x, c, c); }
+	static void opaque (__m256d &x) { __asm__ volatile ("" : "+x" (x)); }
+	static double fold (__m256d x) { return _mm256_cvtsd_f64(x); }
+};
+
+struct epiOp {		//integer SIMD ops share this base, only step() differs
+	typedef __m256i type;
+	static __m256i constant () { return _mm256_set1_epi8(3); }
+	static __m256i init (double seed, int k) { return _mm256_set1_epi32((int)seed + k); }
+	static void opaque (__m256i &x) { __asm__ volatile ("" : "+x" (x)); }
+	static double fold (__m256i x) { return (double)_mm256_extract_epi32(x, 0); }
+};
+
+struct paddbOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_add_epi8(x, c); } };
+struct paddwOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_add_epi16(x, c); } };
+struct padddOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_add_epi32(x, c); } };
+struct paddqOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_add_epi64(x, c); } };
+struct pmullwOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_mullo_epi16(x, c); } };
+struct mulloOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_mullo_epi32(x, c); } };
+struct psllwOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_slli_epi16(x, 1); } };
+struct pslldOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_slli_epi32(x, 1); } };
+struct psllqOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_slli_epi64(x, 1); } };
+struct pshufbOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_shuffle_epi8(x, c); } };
+struct pshufdOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_shuffle_epi32(x, 0x1B); } };
+struct permqOp : epiOp { static __m256i step (__m256i x, __m256i c) { return _mm256_permute4x64_epi64(x, 0x1B); } };	//crosses 128-bit lanes
+
+struct bitOp {		//scalar bit manipulation, 64-bit
+	typedef unsigned long long type;
+	static unsigned long long constant () { return 0x5555555555555555ULL; }
+	static unsigned long long init (double seed, int k) { return 0x0123456789ABCDEFULL + (unsigned long long)seed + k; }
+	static void opaque (unsigned long long &x) { __asm__ volatile ("" : "+r" (x)); }
+	static double fold (unsigned long long x) { return (double)x; }
+};
+
+struct popcntOp : bitOp { static unsigned long long step (unsigned long long x, unsigned long long c) { return _popcnt64(x); } };
+struct lzcntOp : bitOp { static unsigned long long step (unsigned long long x, unsigned long long c) { return _lzcnt_u64(x); } };
+struct tzcntOp : bitOp { static unsigned long long step (unsigned long long x, unsigned long long c) { return _tzcnt_u64(x); } };
+struct pdepOp : bitOp { static unsigned long long step (unsigned long long x, unsigned long long c) { return _pdep_u64(x, c); } };
+struct pextOp : bitOp { static unsigned long long step (unsigned long long x, unsigned long long c) { return _pext_u64(x, c); } };
+
+
+extern const chain_kernel chain_kernels_avx2[] = {
+	{"vfmadd231sd", ISA_AVX2, FLOP, 64, 1, runChains<fmasdOp, 1>, runChains<fmasdOp, TPUT_CHAINS>},
+	{"vfmadd231pd", ISA_AVX2, FLOP, 64, 4, runChains<fmapdOp, 1>, runChains<fmapdOp, TPUT_CHAINS>},
+	{"vpaddb", ISA_AVX2, IOP, 8, 32, runChains<paddbOp, 1>, runChains<paddbOp, TPUT_CHAINS>},
+	{"vpaddw", ISA_AVX2, IOP, 16, 16, runChains<paddwOp, 1>, runChains<paddwOp, TPUT_CHAINS>},
+	{"vpaddd", ISA_AVX2, IOP, 32, 8, runChains<padddOp, 1>, runChains<padddOp, TPUT_CHAINS>},
+	{"vpaddq", ISA_AVX2, IOP, 64, 4, runChains<paddqOp, 1>, runChains<paddqOp, TPUT_CHAINS>},
+	{"vpmullw", ISA_AVX2, IOP, 16, 16, runChains<pmullwOp, 1>, runChains<pmullwOp, TPUT_CHAINS>},
+	{"vpmulld", ISA_AVX2, IOP, 32, 8, runChains<mulloOp, 1>, runChains<mulloOp, TPUT_CHAINS>},
+	{"vpsllw", ISA_AVX2, IOP, 16, 16, runChains<psllwOp, 1>, runChains<psllwOp, TPUT_CHAINS>},
+	{"vpslld", ISA_AVX2, IOP, 32, 8, runChains<pslldOp, 1>, runChains<pslldOp, TPUT_CHAINS>},
+	{"vpsllq", ISA_AVX2, IOP, 64, 4, runChains<psllqOp, 1>, runChains<psllqOp, TPUT_CHAINS>},
+	{"vpshufb", ISA_AVX2, IOP, 8, 32, runChains<pshufbOp, 1>, runChains<pshufbOp, TPUT_CHAINS>},
+	{"vpshufd", ISA_AVX2, IOP, 32, 8, runChains<pshufdOp, 1>, runChains<pshufdOp, TPUT_CHAINS>},
+	{"vpermq", ISA_AVX2, IOP, 64, 4, runChains<permqOp, 1>, runChains<permqOp, TPUT_CHAINS>},
+	{"popcnt", ISA_AVX2, IOP, 64, 1, runChains<popcntOp, 1>, runChains<popcntOp, TPUT_CHAINS>},
+	{"lzcnt", ISA_AVX2, IOP, 64, 1, runChains<lzcntOp, 1>, runChains<lzcntOp, TPUT_CHAINS>},
+	{"tzcnt", ISA_AVX2, IOP, 64, 1, runChains<tzcntOp, 1>, runChains<tzcntOp, TPUT_CHAINS>},
+	{"pdep", ISA_AVX2, IOP, 64, 1, runChains<pdepOp, 1>, runChains<pdepOp, TPUT_CHAINS>},
+	{"pext", ISA_AVX2, IOP, 64, 1, runChains<pextOp, 1>, runChains<pextOp, TPUT_CHAINS>},
+};
+extern const int num_chain_kernels_avx2 = sizeof(chain_kernels_avx2) / sizeof(chain_kernels_avx2[0]);
@@ -0,0 +1,353 @@
+/**
+ * @file cpu_kernels_avx512.cpp
+ * cpu benchmark kernels, AVX-512 F/BW/DQ (512-bit)
+ * built with -mavx512f -mavx512bw -mavx512dq, only called when cpuid reports all three
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <immintrin.h>
+#include "cpu_kernels.h"
+
+
+
+/**
+ * Float operation benchmark
+ * FLOP_CHAINS independent __m512d FMA chains, one fused multiply-add counts as two operations.
+ * acc = acc * 0.9999999 + 1e-7 converges to 1.0, the chains neither overflow nor go denormal.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+double doubleOPs_avx512 (long loop, double seed) {
+	const __m512d mul = _mm512_set1_pd(0.9999999);
+	const __m512d add = _mm512_set1_pd(1e-7);
+	__m512d acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm512_set_pd(seed, seed + 0.1 * c, seed + 0.2 * c, seed + 0.3 * c,
+			seed + 0.4 * c, seed + 0.5 * c, seed + 0.6 * c, seed + 0.7 * c);
+
+	// FLOP_CHAINS chains x (one FMA = mul + add) x 8 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++)
+			acc[c] = _mm512_fmadd_pd(acc[c], mul, add);
+	}
+
+	__m512d sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm512_add_pd(sum, acc[c]);
+	return _mm512_reduce_add_pd(sum);
+}
+
+
+
+/**
+ * Integer operation benchmark
+ * IOP_CHAINS independent __m512i 32-bit multiply-add chains (LCG steps).
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      xor of all chains, or-reduced over the lanes
+ */
+double integerOPs_avx512 (long loop, double seed) {
+	const __m512i mul = _mm512_set1_epi32(1664525);
+	const __m512i add = _mm512_set1_epi32(1013904223);
+	const __m512i step = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	__m512i acc[IOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < IOP_CHAINS; c++)
+		acc[c] = _mm512_add_epi32(_mm512_set1_epi32((int)seed + c), step);
+
+	// IOP_CHAINS chains x (one mul + one add) x 16 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < IOP_CHAINS; c++)
+			acc[c] = _mm512_add_epi32(_mm512_mullo_epi32(acc[c], mul), add);
+	}
+
+	__m512i sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < IOP_CHAINS; c++)
+		sum = _mm512_xor_si512(sum, acc[c]);
+	return (double)_mm512_reduce_or_epi32(sum);
+}
+
+
+
+/**
+ * Single precision float operation benchmark
+ * FLOP_CHAINS independent __m512 FMA chains, one fused multiply-add counts as two operations.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+double floatOPs_avx512 (long loop, double seed) {
+	const __m512 mul = _mm512_set1_ps(0.9999999f);
+	const __m512 add = _mm512_set1_ps(1e-7f);
+	const __m512 step = _mm512_set_ps(1.5f, 1.4f, 1.3f, 1.2f, 1.1f, 1.0f, 0.9f, 0.8f, 0.7f, 0.6f, 0.5f, 0.4f, 0.3f, 0.2f, 0.1f, 0.0f);
+	__m512 acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm512_add_ps(_mm512_set1_ps(seed + 0.1f * c), step);
+
+	// FLOP_CHAINS chains x (one FMA = mul + add) x 16 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++)
+			acc[c] = _mm512_fmadd_ps(acc[c], mul, add);
+	}
+
+	__m512 sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm512_add_ps(sum, acc[c]);
+	return _mm512_reduce_add_ps(sum);
+}
+
+
+
+/**
+ * xor-fold the accumulators of a dot-product kernel
+ * @param  acc DOT_CHAINS accumulators
+ * @return     xor of all accumulators, or-reduced over the lanes
+ */
+static double foldDot (const __m512i *acc) {
+	__m512i sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < DOT_CHAINS; c++)
+		sum = _mm512_xor_si512(sum, acc[c]);
+	return (double)_mm512_reduce_or_epi32(sum);
+}
+
+
+
+/**
+ * Int16 dot product benchmark
+ * DOT_CHAINS independent 32-bit accumulators fed by vpmaddwd, see dot16OPs_sse2.
+ * @param  loop number of iterations
+ * @param  seed initial value of the inputs
+ * @return      xor of all accumulators, or-reduced over the lanes
+ */
+double dot16OPs_avx512 (long loop, double seed) {
+	const __m512i w = _mm512_set1_epi16(3);
+	__m512i in[DOT_CHAINS], acc[DOT_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < DOT_CHAINS; c++) {
+		in[c] = _mm512_set1_epi16((short)seed + c);
+		acc[c] = _mm512_setzero_si512();
+	}
+
+	// DOT_CHAINS chains x (one mul + one add) x 32 int16 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < DOT_CHAINS; c++) {
+			__asm__ volatile ("" : "+v" (in[c]));
+			acc[c] = _mm512_add_epi32(acc[c], _mm512_madd_epi16(in[c], w));
+		}
+	}
+	return foldDot(acc);
+}
+
+
+
+/**
+ * Int8 dot product benchmark, pre-VNNI sequence
+ * vpmaddubsw, vpmaddwd with ones and vpaddd, see dot8OPs_avx2.
+ * @param  loop number of iterations
+ * @param  seed initial value of the inputs
+ * @return      xor of all accumulators, or-reduced over the lanes
+ */
+double dot8OPs_avx512 (long loop, double seed) {
+	const __m512i w = _mm512_set1_epi8(3);
+	const __m512i ones = _mm512_set1_epi16(1);
+	__m512i in[DOT_CHAINS], acc[DOT_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < DOT_CHAINS; c++) {
+		in[c] = _mm512_set1_epi8((char)seed + c);
+		acc[c] = _mm512_setzero_si512();
+	}
+
+	// DOT_CHAINS chains x (one mul + one add) x 64 int8 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < DOT_CHAINS; c++) {
+			__asm__ volatile ("" : "+v" (in[c]));
+			acc[c] = _mm512_add_epi32(acc[c], _mm512_madd_epi16(_mm512_maddubs_epi16(in[c], w), ones));
+		}
+	}
+	return foldDot(acc);
+}
+
+
+
+/**
+ * Int8 dot product benchmark, AVX-512 VNNI
+ * one vpdpbusd per chain does the whole u8 x s8 -> s32 multiply-accumulate.
+ * Compiled for avx512vnni on this function only, called when cpuid reports it.
+ * @param  loop number of iterations
+ * @param  seed initial value of the inputs
+ * @return      xor of all accumulators, or-reduced over the lanes
+ */
+__attribute__((target("avx512vnni")))
+double dot8VNNI_avx512 (long loop, double seed) {
+	const __m512i w = _mm512_set1_epi8(3);
+	__m512i in[DOT_CHAINS], acc[DOT_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < DOT_CHAINS; c++) {
+		in[c] = _mm512_set1_epi8((char)seed + c);
+		acc[c] = _mm512_setzero_si512();
+	}
+
+	// DOT_CHAINS chains x (one mul + one add) x 64 int8 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < DOT_CHAINS; c++) {
+			__asm__ volatile ("" : "+v" (in[c]));
+			acc[c] = _mm512_dpbusd_epi32(acc[c], in[c], w);
+		}
+	}
+	return foldDot(acc);
+}
+
+
+
+/**
+ * fp16 conversion benchmark
+ * FLOP_CHAINS chains of fp32 -> fp16 -> fp32 round trips on 16 lanes, see fp16Cvt_avx2.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+double fp16Cvt_avx512 (long loop, double seed) {
+	__m512 acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm512_set1_ps(seed + 0.5f * c);
+
+	// FLOP_CHAINS chains x 2 conversions x 16 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++)
+			acc[c] = _mm512_cvtph_ps(_mm512_cvtps_ph(acc[c], _MM_FROUND_TO_NEAREST_INT));
+	}
+
+	__m512 sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm512_add_ps(sum, acc[c]);
+	return _mm512_reduce_add_ps(sum);
+}
+
+
+
+/**
+ * bf16 conversion benchmark, AVX-512 BF16
+ * FLOP_CHAINS chains of fp32 -> bf16 (vcvtne2ps2bf16) -> fp32 round trips on 16 lanes.
+ * There is no widening instruction, bf16 -> fp32 is a zero-extend and a 16-bit shift,
+ * as in real code. One narrowing and one widening count as one op per element each.
+ * Compiled for avx512bf16 on this function only, called when cpuid reports it.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+__attribute__((target("avx512bf16")))
+double bf16Cvt_avx512 (long loop, double seed) {
+	__m512 acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm512_set1_ps(seed + 0.5f * c);
+
+	// FLOP_CHAINS chains x 2 conversions x 16 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++) {
+			__m256i bf = _mm512_castsi512_si256((__m512i)_mm512_cvtne2ps_pbh(acc[c], acc[c]));
+			acc[c] = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(bf), 16));
+		}
+	}
+
+	__m512 sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm512_add_ps(sum, acc[c]);
+	return _mm512_reduce_add_ps(sum);
+}
+
+
+
+/*
+* latency/throughput chain operations, see runChains in cpu_kernels.h
+ */
+struct addpdOp {
+	typedef __m512d type;
+	static __m512d constant () { return _mm512_set1_pd(1.0); }
+	static __m512d init (double seed, int k) { return _mm512_set1_pd(seed + k + 0.5); }
+	static __m512d step (__m512d x, __m512d c) { return _mm512_add_pd(x, c); }
+	static void opaque (__m512d &x) { __asm__ volatile ("" : "+v" (x)); }
+	static double fold (__m512d x) { return _mm512_cvtsd_f64(x); }
+};
+
+struct mulpdOp : addpdOp {
+	static __m512d step (__m512d x, __m512d c) { return _mm512_mul_pd(x, c); }
+};
+
+struct fmapdOp : addpdOp {	//x = x * 1.0 + 1.0
+	static __m512d step (__m512d x, __m512d c) { return _mm512_fmadd_pd(x, c, c); }
+};
+
+struct divpdOp : addpdOp {	//x alternates between x0 and 1/x0
+	static __m512d step (__m512d x, __m512d c) { return _mm512_div_pd(c, x); }
+};
+
+struct sqrtpdOp : addpdOp {
+	static __m512d init (double seed, int k) { return _mm512_set1_pd(seed + k + 1.5); }
+	static __m512d step (__m512d x, __m512d c) { return _mm512_sqrt_pd(x); }
+};
+
+struct epiOp {		//integer SIMD ops share this base, only step() differs
+	typedef __m512i type;
+	static __m512i constant () { return _mm512_set1_epi8(3); }
+	static __m512i init (double seed, int k) { return _mm512_set1_epi32((int)seed + k); }
+	static void opaque (__m512i &x) { __asm__ volatile ("" : "+v" (x)); }
+	static double fold (__m512i x) { return (double)_mm_cvtsi128_si32(_mm512_castsi512_si128(x)); }
+};
+
+struct paddbOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_add_epi8(x, c); } };
+struct paddwOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_add_epi16(x, c); } };
+struct padddOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_add_epi32(x, c); } };
+struct paddqOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_add_epi64(x, c); } };
+struct pmullwOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_mullo_epi16(x, c); } };
+struct mulloOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_mullo_epi32(x, c); } };
+struct pmullqOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_mullo_epi64(x, c); } };
+struct psllwOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_slli_epi16(x, 1); } };
+struct pslldOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_slli_epi32(x, 1); } };
+struct psllqOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_slli_epi64(x, 1); } };
+struct pshufbOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_shuffle_epi8(x, c); } };
+struct pshufdOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_shuffle_epi32(x, (_MM_PERM_ENUM)0x1B); } };
+struct permqOp : epiOp { static __m512i step (__m512i x, __m512i c) { return _mm512_permutex_epi64(x, 0x1B); } };
+
+
+extern const chain_kernel chain_kernels_avx512[] = {
+	{"vaddpd", ISA_AVX512, FLOP, 64, 8, runChains<addpdOp, 1>, runChains<addpdOp, TPUT_CHAINS>},
+	{"vmulpd", ISA_AVX512, FLOP, 64, 8, runChains<mulpdOp, 1>, runChains<mulpdOp, TPUT_CHAINS>},
+	{"vfmadd231pd", ISA_AVX512, FLOP, 64, 8, runChains<fmapdOp, 1>, runChains<fmapdOp, TPUT_CHAINS>},
+	{"vdivpd", ISA_AVX512, FLOP, 64, 8, runChains<divpdOp, 1>, runChains<divpdOp, TPUT_CHAINS>},
+	{"vsqrtpd", ISA_AVX512, FLOP, 64, 8, runChains<sqrtpdOp, 1>, runChains<sqrtpdOp, TPUT_CHAINS>},
+	{"vpaddb", ISA_AVX512, IOP, 8, 64, runChains<paddbOp, 1>, runChains<paddbOp, TPUT_CHAINS>},
+	{"vpaddw", ISA_AVX512, IOP, 16, 32, runChains<paddwOp, 1>, runChains<paddwOp, TPUT_CHAINS>},
+	{"vpaddd", ISA_AVX512, IOP, 32, 16, runChains<padddOp, 1>, runChains<padddOp, TPUT_CHAINS>},
+	{"vpaddq", ISA_AVX512, IOP, 64, 8, runChains<paddqOp, 1>, runChains<paddqOp, TPUT_CHAINS>},
+	{"vpmullw", ISA_AVX512, IOP, 16, 32, runChains<pmullwOp, 1>, runChains<pmullwOp, TPUT_CHAINS>},
+	{"vpmulld", ISA_AVX512, IOP, 32, 16, runChains<mulloOp, 1>, runChains<mulloOp, TPUT_CHAINS>},
+	{"vpmullq", ISA_AVX512, IOP, 64, 8, runChains<pmullqOp, 1>, runChains<pmullqOp, TPUT_CHAINS>},
+	{"vpsllw", ISA_AVX512, IOP, 16, 32, runChains<psllwOp, 1>, runChains<psllwOp, TPUT_CHAINS>},
+	{"vpslld", ISA_AVX512, IOP, 32, 16, runChains<pslldOp, 1>, runChains<pslldOp, TPUT_CHAINS>},
+	{"vpsllq", ISA_AVX512, IOP, 64, 8, runChains<psllqOp, 1>, runChains<psllqOp, TPUT_CHAINS>},
+	{"vpshufb", ISA_AVX512, IOP, 8, 64, runChains<pshufbOp, 1>, runChains<pshufbOp, TPUT_CHAINS>},
+	{"vpshufd", ISA_AVX512, IOP, 32, 16, runChains<pshufdOp, 1>, runChains<pshufdOp, TPUT_CHAINS>},
+	{"vpermq", ISA_AVX512, IOP, 64, 8, runChains<permqOp, 1>, runChains<permqOp, TPUT_CHAINS>},
+};
+extern const int num_chain_kernels_avx512 = sizeof(chain_kernels_avx512) / sizeof(chain_kernels_avx512[0]);
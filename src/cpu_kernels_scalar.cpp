@@ -0,0 +1,194 @@
+/**
+ * @file cpu_kernels_scalar.cpp
+ * cpu benchmark kernels, scalar x86-64 baseline
+ * built with -fno-tree-vectorize so every chain stays a scalar instruction
+ * and -fno-math-errno so sqrt is a single instruction
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <cstddef>
+#include <cmath>		//sqrt, a single sqrtsd with -fno-math-errno
+#include "cpu_kernels.h"
+
+
+
+/**
+ * Float operation benchmark
+ * FLOP_CHAINS independent multiply-add chains, so the FP pipes never wait on a previous result.
+ * acc = acc * 0.9999999 + 1e-7 converges to 1.0, the chains neither overflow nor go denormal.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains
+ */
+double doubleOPs_scalar (long loop, double seed) {
+	const double mul = 0.9999999;
+	const double add = 1e-7;
+	double acc0 = seed, acc1 = seed + 0.1, acc2 = seed + 0.2, acc3 = seed + 0.3;
+	double acc4 = seed + 0.4, acc5 = seed + 0.5, acc6 = seed + 0.6, acc7 = seed + 0.7;
+	double acc8 = seed + 0.8, acc9 = seed + 0.9, acc10 = seed + 1.0, acc11 = seed + 1.1;
+
+	// 12 chains x (one mul + one add) = FLOP_CHAINS * 2 operations per iteration
+	for (long i = 0; i < loop; i++) {
+		acc0 = acc0 * mul + add;
+		acc1 = acc1 * mul + add;
+		acc2 = acc2 * mul + add;
+		acc3 = acc3 * mul + add;
+		acc4 = acc4 * mul + add;
+		acc5 = acc5 * mul + add;
+		acc6 = acc6 * mul + add;
+		acc7 = acc7 * mul + add;
+		acc8 = acc8 * mul + add;
+		acc9 = acc9 * mul + add;
+		acc10 = acc10 * mul + add;
+		acc11 = acc11 * mul + add;
+	}
+	return acc0 + acc1 + acc2 + acc3 + acc4 + acc5 + acc6 + acc7 + acc8 + acc9 + acc10 + acc11;
+}
+
+
+
+/**
+ * Integer operation benchmark
+ * IOP_CHAINS independent 64-bit multiply-add chains (LCG steps), wrapping is well defined.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      xor of all chains
+ */
+double integerOPs_scalar (long loop, double seed) {
+	const size_t mul = 6364136223846793005UL;
+	const size_t add = 1442695040888963407UL;
+	size_t acc0 = (size_t)seed, acc1 = acc0 + 1, acc2 = acc0 + 2, acc3 = acc0 + 3;
+	size_t acc4 = acc0 + 4, acc5 = acc0 + 5, acc6 = acc0 + 6, acc7 = acc0 + 7;
+
+	// 8 chains x (one mul + one add) = IOP_CHAINS * 2 operations per iteration
+	for (long i = 0; i < loop; i++) {
+		acc0 = acc0 * mul + add;
+		acc1 = acc1 * mul + add;
+		acc2 = acc2 * mul + add;
+		acc3 = acc3 * mul + add;
+		acc4 = acc4 * mul + add;
+		acc5 = acc5 * mul + add;
+		acc6 = acc6 * mul + add;
+		acc7 = acc7 * mul + add;
+	}
+	return (double)(acc0 ^ acc1 ^ acc2 ^ acc3 ^ acc4 ^ acc5 ^ acc6 ^ acc7);
+}
+
+
+
+/**
+ * Single precision float operation benchmark
+ * same chains as doubleOPs_scalar in float, one mulss and one addss per chain.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains
+ */
+double floatOPs_scalar (long loop, double seed) {
+	const float mul = 0.9999999f;
+	const float add = 1e-7f;
+	float acc0 = seed, acc1 = seed + 0.1f, acc2 = seed + 0.2f, acc3 = seed + 0.3f;
+	float acc4 = seed + 0.4f, acc5 = seed + 0.5f, acc6 = seed + 0.6f, acc7 = seed + 0.7f;
+	float acc8 = seed + 0.8f, acc9 = seed + 0.9f, acc10 = seed + 1.0f, acc11 = seed + 1.1f;
+
+	// 12 chains x (one mul + one add) = FLOP_CHAINS * 2 operations per iteration
+	for (long i = 0; i < loop; i++) {
+		acc0 = acc0 * mul + add;
+		acc1 = acc1 * mul + add;
+		acc2 = acc2 * mul + add;
+		acc3 = acc3 * mul + add;
+		acc4 = acc4 * mul + add;
+		acc5 = acc5 * mul + add;
+		acc6 = acc6 * mul + add;
+		acc7 = acc7 * mul + add;
+		acc8 = acc8 * mul + add;
+		acc9 = acc9 * mul + add;
+		acc10 = acc10 * mul + add;
+		acc11 = acc11 * mul + add;
+	}
+	return acc0 + acc1 + acc2 + acc3 + acc4 + acc5 + acc6 + acc7 + acc8 + acc9 + acc10 + acc11;
+}
+
+
+
+/*
+* latency/throughput chain operations, see runChains in cpu_kernels.h
+* constants go through opaque(), so x*1.0 or c/x with c = 1.0 cannot be simplified
+ */
+struct faddOp {
+	typedef double type;
+	static double constant () { return 1.0; }
+	static double init (double seed, int k) { return seed + k; }
+	static double step (double x, double c) { return x + c; }
+	static void opaque (double &x) { __asm__ volatile ("" : "+x" (x)); }
+	static double fold (double x) { return x; }
+};
+
+struct fmulOp : faddOp {
+	static double step (double x, double c) { return x * c; }
+};
+
+struct fdivOp : faddOp {	//x alternates between x0 and 1/x0, never degenerates
+	static double init (double seed, int k) { return seed + 0.2345 + k; }
+	static double step (double x, double c) { return c / x; }
+};
+
+struct fsqrtOp : faddOp {	//converges to 1.0 from a normal operand
+	static double init (double seed, int k) { return seed + 1.5 + k; }
+	static double step (double x, double c) { return sqrt(x); }
+};
+
+struct iaddOp {
+	typedef size_t type;
+	static size_t constant () { return 1; }
+	static size_t init (double seed, int k) { return (size_t)seed + k; }
+	static size_t step (size_t x, size_t c) { return x + c; }
+	static void opaque (size_t &x) { __asm__ volatile ("" : "+r" (x)); }
+	static double fold (size_t x) { return (double)x; }
+};
+
+struct imulOp : iaddOp {
+	static size_t constant () { return 6364136223846793005UL; }
+	static size_t step (size_t x, size_t c) { return x * c; }
+};
+
+struct idivOp : iaddOp {	//x alternates around sqrt(c), 62-bit dividend by 24..38-bit divisors
+	static size_t constant () { return 1UL << 62; }
+	static size_t init (double seed, int k) { return 12345677 + (size_t)seed + k; }
+	static size_t step (size_t x, size_t c) { return c / x; }
+};
+
+
+struct shlOp : iaddOp {		//variable count shift, shl r64, cl
+	static size_t step (size_t x, size_t c) { return x << (c & 63); }
+};
+
+struct rolOp : iaddOp {		//variable count rotate, rol r64, cl
+	static size_t constant () { return 13; }
+	static size_t step (size_t x, size_t c) { return (x << (c & 63)) | (x >> (-c & 63)); }
+};
+
+
+
+/**
+ * dependent chain of 64-bit integer adds, one cycle per add on every x86 core,
+ * so adds per second give the core clock
+ */
+double addChain_scalar (long loop, double seed) {
+	return runChains<iaddOp, 1>(loop, seed);
+}
+
+
+extern const chain_kernel chain_kernels_scalar[] = {
+	{"addsd", ISA_SCALAR, FLOP, 64, 1, runChains<faddOp, 1>, runChains<faddOp, TPUT_CHAINS>},
+	{"mulsd", ISA_SCALAR, FLOP, 64, 1, runChains<fmulOp, 1>, runChains<fmulOp, TPUT_CHAINS>},
+	{"divsd", ISA_SCALAR, FLOP, 64, 1, runChains<fdivOp, 1>, runChains<fdivOp, TPUT_CHAINS>},
+	{"sqrtsd", ISA_SCALAR, FLOP, 64, 1, runChains<fsqrtOp, 1>, runChains<fsqrtOp, TPUT_CHAINS>},
+	{"add", ISA_SCALAR, IOP, 64, 1, runChains<iaddOp, 1>, runChains<iaddOp, TPUT_CHAINS>},
+	{"imul", ISA_SCALAR, IOP, 64, 1, runChains<imulOp, 1>, runChains<imulOp, TPUT_CHAINS>},
+	{"div", ISA_SCALAR, IOP, 64, 1, runChains<idivOp, 1>, runChains<idivOp, TPUT_CHAINS>},
+	{"shl", ISA_SCALAR, IOP, 64, 1, runChains<shlOp, 1>, runChains<shlOp, TPUT_CHAINS>},
+	{"rol", ISA_SCALAR, IOP, 64, 1, runChains<rolOp, 1>, runChains<rolOp, TPUT_CHAINS>},
+};
+extern const int num_chain_kernels_scalar = sizeof(chain_kernels_scalar) / sizeof(chain_kernels_scalar[0]);
@@ -0,0 +1,217 @@
+/**
+ * @file cpu_kernels_sse2.cpp
+ * cpu benchmark kernels, SSE2 (128-bit)
+ * built with -msse2, only called when cpuid reports SSE2
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <emmintrin.h>
+#include "cpu_kernels.h"
+
+
+
+/**
+ * Float operation benchmark
+ * FLOP_CHAINS independent __m128d multiply-add chains.
+ * acc = acc * 0.9999999 + 1e-7 converges to 1.0, the chains neither overflow nor go denormal.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+double doubleOPs_sse2 (long loop, double seed) {
+	const __m128d mul = _mm_set1_pd(0.9999999);
+	const __m128d add = _mm_set1_pd(1e-7);
+	__m128d acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm_set_pd(seed, seed + 0.1 * c);
+
+	// FLOP_CHAINS chains x (one mul + one add) x 2 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++)
+			acc[c] = _mm_add_pd(_mm_mul_pd(acc[c], mul), add);
+	}
+
+	__m128d sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm_add_pd(sum, acc[c]);
+	double lanes[2];
+	_mm_storeu_pd(lanes, sum);
+	return lanes[0] + lanes[1];
+}
+
+
+
+/**
+ * Integer operation benchmark
+ * IOP_CHAINS independent __m128i multiply-add chains.
+ * SSE2 has no 32-bit low multiply, so each chain uses _mm_mul_epu32 (32x32->64)
+ * and _mm_add_epi64 on the two 64-bit lanes.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      xor of all chains and lanes
+ */
+double integerOPs_sse2 (long loop, double seed) {
+	const __m128i mul = _mm_set1_epi64x(1664525);
+	const __m128i add = _mm_set1_epi64x(1013904223);
+	__m128i acc[IOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < IOP_CHAINS; c++)
+		acc[c] = _mm_set_epi64x((long long)seed, (long long)seed + c);
+
+	// IOP_CHAINS chains x (one mul + one add) x 2 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < IOP_CHAINS; c++)
+			acc[c] = _mm_add_epi64(_mm_mul_epu32(acc[c], mul), add);
+	}
+
+	__m128i sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < IOP_CHAINS; c++)
+		sum = _mm_xor_si128(sum, acc[c]);
+	long long lanes[2];
+	_mm_storeu_si128((__m128i *)lanes, sum);
+	return (double)(lanes[0] ^ lanes[1]);
+}
+
+
+
+/**
+ * Single precision float operation benchmark
+ * FLOP_CHAINS independent __m128 multiply-add chains.
+ * @param  loop number of iterations
+ * @param  seed initial value of the chains
+ * @return      sum of all chains and lanes
+ */
+double floatOPs_sse2 (long loop, double seed) {
+	const __m128 mul = _mm_set1_ps(0.9999999f);
+	const __m128 add = _mm_set1_ps(1e-7f);
+	__m128 acc[FLOP_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < FLOP_CHAINS; c++)
+		acc[c] = _mm_set_ps(seed, seed + 0.1f * c, seed + 0.2f * c, seed + 0.3f * c);
+
+	// FLOP_CHAINS chains x (one mul + one add) x 4 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < FLOP_CHAINS; c++)
+			acc[c] = _mm_add_ps(_mm_mul_ps(acc[c], mul), add);
+	}
+
+	__m128 sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < FLOP_CHAINS; c++)
+		sum = _mm_add_ps(sum, acc[c]);
+	float lanes[4];
+	_mm_storeu_ps(lanes, sum);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+
+
+/**
+ * Int16 dot product benchmark
+ * DOT_CHAINS independent 32-bit accumulators, each adds pmaddwd of its own input and the weights,
+ * the way a GEMV inner loop does. opaque() makes the inputs look new every iteration,
+ * so the multiplies cannot be hoisted out of the loop.
+ * One pmaddwd lane pair counts as two multiplies and two adds, 2 ops per int16 element.
+ * @param  loop number of iterations
+ * @param  seed initial value of the inputs
+ * @return      xor of all accumulators and lanes
+ */
+double dot16OPs_sse2 (long loop, double seed) {
+	const __m128i w = _mm_set1_epi16(3);
+	__m128i in[DOT_CHAINS], acc[DOT_CHAINS];
+#pragma GCC unroll 16
+	for (int c = 0; c < DOT_CHAINS; c++) {
+		in[c] = _mm_set1_epi16((short)seed + c);
+		acc[c] = _mm_setzero_si128();
+	}
+
+	// DOT_CHAINS chains x (one mul + one add) x 8 int16 lanes per iteration
+	for (long i = 0; i < loop; i++) {
+#pragma GCC unroll 16
+		for (int c = 0; c < DOT_CHAINS; c++) {
+			__asm__ volatile ("" : "+x" (in[c]));
+			acc[c] = _mm_add_epi32(acc[c], _mm_madd_epi16(in[c], w));
+		}
+	}
+
+	__m128i sum = acc[0];
+#pragma GCC unroll 16
+	for (int c = 1; c < DOT_CHAINS; c++)
+		sum = _mm_xor_si128(sum, acc[c]);
+	return (double)_mm_cvtsi128_si32(sum);
+}
+
+
+
+/*
+* latency/throughput chain operations, see runChains in cpu_kernels.h
+ */
+struct addpdOp {
+	typedef __m128d type;
+	static __m128d constant () { return _mm_set1_pd(1.0); }
+	static __m128d init (double seed, int k) { return _mm_set_pd(seed + k, seed + k + 0.5); }
+	static __m128d step (__m128d x, __m128d c) { return _mm_add_pd(x, c); }
+	static void opaque (__m128d &x) { __asm__ volatile ("" : "+x" (x)); }
+	static double fold (__m128d x) { return _mm_cvtsd_f64(_mm_add_pd(x, _mm_unpackhi_pd(x, x))); }
+};
+
+struct mulpdOp : addpdOp {
+	static __m128d step (__m128d x, __m128d c) { return _mm_mul_pd(x, c); }
+};
+
+struct divpdOp : addpdOp {	//x alternates between x0 and 1/x0
+	static __m128d step (__m128d x, __m128d c) { return _mm_div_pd(c, x); }
+};
+
+struct sqrtpdOp : addpdOp {
+	static __m128d init (double seed, int k) { return _mm_set_pd(seed + k + 1.5, seed + k + 2.5); }
+	static __m128d step (__m128d x, __m128d c) { return _mm_sqrt_pd(x); }
+};
+
+struct epiOp {		//integer SIMD ops share this base, only step() differs
+	typedef __m128i type;
+	static __m128i constant () { return _mm_set1_epi8(3); }
+	static __m128i init (double seed, int k) { return _mm_set_epi64x((long long)seed + k, (long long)seed + k + 1); }
+	static void opaque (__m128i &x) { __asm__ volatile ("" : "+x" (x)); }
+	static double fold (__m128i x) { return (double)_mm_cvtsi128_si64(x); }
+};
+
+struct paddbOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_add_epi8(x, c); } };
+struct paddwOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_add_epi16(x, c); } };
+struct padddOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_add_epi32(x, c); } };
+struct paddqOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_add_epi64(x, c); } };
+struct pmullwOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_mullo_epi16(x, c); } };
+struct muludqOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_mul_epu32(x, c); } };	//32x32->64
+struct psllwOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_slli_epi16(x, 1); } };
+struct pslldOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_slli_epi32(x, 1); } };
+struct psllqOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_slli_epi64(x, 1); } };
+struct pshuflwOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_shufflelo_epi16(x, 0x1B); } };
+struct pshufdOp : epiOp { static __m128i step (__m128i x, __m128i c) { return _mm_shuffle_epi32(x, 0x1B); } };
+
+
+extern const chain_kernel chain_kernels_sse2[] = {
+	{"addpd", ISA_SSE2, FLOP, 64, 2, runChains<addpdOp, 1>, runChains<addpdOp, TPUT_CHAINS>},
+	{"mulpd", ISA_SSE2, FLOP, 64, 2, runChains<mulpdOp, 1>, runChains<mulpdOp, TPUT_CHAINS>},
+	{"divpd", ISA_SSE2, FLOP, 64, 2, runChains<divpdOp, 1>, runChains<divpdOp, TPUT_CHAINS>},
+	{"sqrtpd", ISA_SSE2, FLOP, 64, 2, runChains<sqrtpdOp, 1>, runChains<sqrtpdOp, TPUT_CHAINS>},
+	{"paddb", ISA_SSE2, IOP, 8, 16, runChains<paddbOp, 1>, runChains<paddbOp, TPUT_CHAINS>},
+	{"paddw", ISA_SSE2, IOP, 16, 8, runChains<paddwOp, 1>, runChains<paddwOp, TPUT_CHAINS>},
+	{"paddd", ISA_SSE2, IOP, 32, 4, runChains<padddOp, 1>, runChains<padddOp, TPUT_CHAINS>},
+	{"paddq", ISA_SSE2, IOP, 64, 2, runChains<paddqOp, 1>, runChains<paddqOp, TPUT_CHAINS>},
+	{"pmullw", ISA_SSE2, IOP, 16, 8, runChains<pmullwOp, 1>, runChains<pmullwOp, TPUT_CHAINS>},
+	{"pmuludq", ISA_SSE2, IOP, 64, 2, runChains<muludqOp, 1>, runChains<muludqOp, TPUT_CHAINS>},
+	{"psllw", ISA_SSE2, IOP, 16, 8, runChains<psllwOp, 1>, runChains<psllwOp, TPUT_CHAINS>},
+	{"pslld", ISA_SSE2, IOP, 32, 4, runChains<pslldOp, 1>, runChains<pslldOp, TPUT_CHAINS>},
+	{"psllq", ISA_SSE2, IOP, 64, 2, runChains<psllqOp, 1>, runChains<psllqOp, TPUT_CHAINS>},
+	{"pshuflw", ISA_SSE2, IOP, 16, 8, runChains<pshuflwOp, 1>, runChains<pshuflwOp, TPUT_CHAINS>},
+	{"pshufd", ISA_SSE2, IOP, 32, 4, runChains<pshufdOp, 1>, runChains<pshufdOp, TPUT_CHAINS>},
+};
+extern const int num_chain_kernels_sse2 = sizeof(chain_kernels_sse2) / sizeof(chain_kernels_sse2[0]);
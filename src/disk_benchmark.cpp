@@ -12,13 +12,18 @@
 #include <cstring>
 #include <iostream>
 #include <sys/time.h>
+#include <sched.h>		//sched_getcpu
 #include <unistd.h>		
+#include <getopt.h>		//getopt_long
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>	//major, minor
+#include <sys/mman.h>		//mmap, madvise, msync
+#include <sys/resource.h>	//getrusage, page faults
 #include <fcntl.h>
+#include <cerrno>
+#include <fstream>		//sysfs, --hist-file
 #include <string>
-#include <algorithm>	//std::generate
-#include <random>		//random function
 #include "disk_benchmark.h"
 
 using namespace std;
@@ -28,15 +33,29 @@ using namespace std;
  */
 void helper (char *arg) {
 	cout<<arg<<": Disk benchmark tool, Version 0.0.1 (lchen96@hawk.iit.edu)"<<endl<<endl;
-	cout<<"usage:\t"<<arg<<" [-h] [-i] [-o <operation>] [-t <threads>] [-s <datasize>] [-b <blocksize] [-r <repeats>]"<<endl;
+	cout<<"usage:\t"<<arg<<" [-h] [-i] [-d] [-o <operation>] [-e <engine>] [-q <depth>] [-a <advice>] [--populate] [--hist-file=<file>] [-t <threads>] [-s <datasize>] [-b <blocksize] [-r <repeats>] [-p <placement>] [-c <cpulist>] [--sweep-threads[=linear|pow2]] [--sweep-qd]"<<endl;
 	cout<<"Arguments:"<<endl;
 	cout<<"\t-h\tlist available commands"<<endl;
-	cout<<"\t-i\tignore file craetion (test file already exists)"<<endl;
-	cout<<"\t-o\toperation type, read&write=0 (defualted), sqtread=1, rdmread=2"<<endl;
-	cout<<"\t-t\tnumber of threads ( <= "<<MAXTHREADS<<") [default = 1]"<<endl;
+	cout<<"\t-i\tignore file craetion (test file already exists, at least as large as the data size)"<<endl
+		<<"\t\twithout -i, a test file of the same size left by an earlier run is reused if its sidecar ("<<META_SUFFIX<<") matches"<<endl;
+	cout<<"\t-d\tdirect I/O (O_DIRECT), bypass the page cache, the block size must be a multiple of the device's logical block size"<<endl
+		<<"\t\tfalls back to buffered I/O if the filesystem does not support it [default = buffered]"<<endl;
+	cout<<"\t-o\toperation type, read&write=0 (defualted), sqtread=1, rdmread=2,"<<endl
+		<<"\t\tthrough a mapping of the files: mmap sqtread=3, mmap rdmread=4, mmap read&write=5 (msync at the end)"<<endl;
+	cout<<"\t-e\tI/O engine, psync=0 (defualted, one blocking pread/pwrite at a time), io_uring=1"<<endl;
+	cout<<"\t-q\tio_uring queue depth, requests in flight per thread (1 to "<<URING_MAXDEPTH<<") [default = "<<DEFAULTDEPTH<<"]"<<endl;
+	cout<<"\t-a\tmmap: madvise hint, none=0 (defualted), sequential=1, random=2, willneed=3"<<endl;
+	cout<<"\t--populate\tmmap: map with MAP_POPULATE, the file is faulted in before the timed run"<<endl;
+	cout<<"\t--hist-file\twrite the merged latency histogram of every run to a file (low, high, count, cumulative fraction)"<<endl;
+	cout<<"\t-t\tnumber of threads ( <= "<<onlineCpus()<<" online CPUs) [default = 1]"<<endl;
 	cout<<"\t-s\tfile size to be operated, ending with B/KB/MB/GB (>= "<<BYTE_IN_GB(MINDATASIZE)<<"GB) [default = 10GB]"<<endl;
 	cout<<"\t-b\tblock size, ending with B/KB/MB, default with B (<= "<<BYTE_IN_MB(MAXBLOCKSIZE)<<"MB) [default = 8B]"<<endl;
 	cout<<"\t-r\tnumber of repeated benchmark tests[default = 1]"<<endl;
+	cout<<"\t-p\tthread placement, compact=0, scatter=1, physical cores only=2, SMT pairs=3 [default = unpinned]"<<endl;
+	cout<<"\t-c\tpin threads to an explicit CPU list, like 0-3,8"<<endl;
+	cout<<"\t--sweep-threads\trun every thread count from 1 to -t (default: all online CPUs) on the same file,"<<endl
+		<<"\t\tlinear or powers of two (defaulted), and report speedup, efficiency and the serial fraction"<<endl;
+	cout<<"\t--sweep-qd\tio_uring: run every power-of-two queue depth from 1 to -q, and report IOPS and bandwidth per depth"<<endl;
 	cout<<endl;
 
 }
@@ -79,8 +98,15 @@ int main (int argc, char *argv[]) {
 	 */
 	int c;
 	int flag;
-	// only accepts "hiotsbi" arguments, where for "otsbr" the argument can be optional
-	while ((c = getopt (argc, argv, ":hio::t::s::b::r::")) != -1) 
+	static struct option long_options[] = {
+		{"sweep-threads", optional_argument, NULL, SWEEP_OPT},
+		{"sweep-qd", no_argument, NULL, QD_SWEEP_OPT},
+		{"populate", no_argument, NULL, POPULATE_OPT},
+		{"hist-file", required_argument, NULL, HIST_OPT},
+		{0, 0, 0, 0}
+	};
+	// only accepts "hidoeqatsbipc" arguments, where for "otsbrp" the argument can be optional
+	while ((c = getopt_long (argc, argv, ":hido::e:q:a:t::s::b::r::p::c:", long_options, NULL)) != -1) 
 		switch (c) {
 			case 'h':
 				helper(argv[0]);
@@ -88,6 +114,9 @@ int main (int argc, char *argv[]) {
 			case 'i':
 				skip_createfile = true;
 				break;
+			case 'd':
+				direct_io = true;
+				break;
 			case 'o':
 				flag = stoi(optarg);
 				if (flag == 0)
@@ -96,17 +125,48 @@ int main (int argc, char *argv[]) {
 					op_type = SR;
 				else if (flag == 2)
 					op_type = RR;
+				else if (flag == 3)
+					op_type = MSR;
+				else if (flag == 4)
+					op_type = MRR;
+				else if (flag == 5)
+					op_type = MRW;
 				else {
-					cerr<<"option type can only be 0,1 or 2!\n"<<endl;
+					cerr<<"option type can only be 0 to 5!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'e':
+				engine = stoi(optarg);
+				if (engine != ENGINE_PSYNC && engine != ENGINE_URING) {
+					cerr<<"engine can only be 0 or 1!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'q':
+				queue_depth = atoi(optarg);
+				if (queue_depth < 1 || queue_depth > URING_MAXDEPTH) {
+					cerr<<"Queue depth must be 1 to "<<URING_MAXDEPTH<<"!"<<endl;
+					exit(2);
+				}
+				break;
+			case 'a':
+				advice = stoi(optarg);
+				if (advice < ADV_NONE || advice > ADV_WILLNEED) {
+					cerr<<"madvise hint can only be 0 to 3!\n"<<endl;
 					helper(argv[0]);
 					exit(1);
 				}
 				break;
 			case 't':
-				if ((thread_num = atoi(optarg)) > MAXTHREADS) {
-					cout<<"Exceed the supported thread limit! ( <= "<<MAXTHREADS<<")"<<endl;
+				thread_num = atoi(optarg);
+				if (thread_num < 1 || thread_num > onlineCpus()) {
+					cout<<"Thread number must be 1 to the online CPU count ("<<onlineCpus()<<")!"<<endl;
 					exit(2);
 				}
+				thread_set = true;
 				break;
 			case 's':
 				if ((data_size = getSizeInByte (optarg)) == -1) {
@@ -133,6 +193,38 @@ int main (int argc, char *argv[]) {
 			case 'r':
 				repeat_num = stoi(optarg);
 				break;
+			case 'p':
+				placement = stoi(optarg);
+				if (placement < PIN_COMPACT || placement >= PIN_LIST) {
+					cerr<<"placement can only be 0 to "<<PIN_LIST - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'c':
+				placement = PIN_LIST;
+				cpu_list = optarg;
+				break;
+			case SWEEP_OPT:
+				if ((sweep_mode = parseSweepMode(optarg)) == -1) {
+					cerr<<"sweep can only be linear or pow2!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case QD_SWEEP_OPT:
+				sweep_depth = true;
+				break;
+			case POPULATE_OPT:
+				populate = true;
+				break;
+			case HIST_OPT:
+				histOut.open(optarg);
+				if (!histOut) {
+					cerr<<"Cannot create file: "<<optarg<<endl;
+					exit(3);
+				}
+				break;
 			case ':':	/*missing option argument, using default value*/
 				if (optopt == 'o') 
 					op_type = RDW;
@@ -144,6 +236,8 @@ int main (int argc, char *argv[]) {
 					block_size = EBBLOCK;
 				else if (optopt == 'r')
 					repeat_num = 1;
+				else if (optopt == 'p')
+					placement = PIN_COMPACT;
 				break;
 			case '?':	/* invalid option*/
 			default:
@@ -159,13 +253,49 @@ int main (int argc, char *argv[]) {
 			data_size = GB_IN_BYTE(4L);		//set data size to 4GB
 
 
+		//O_DIRECT transfers whole logical blocks of the device, from and to aligned memory
+		if (direct_io) {
+			io_align = directAlignment(".");
+			if (block_size % io_align != 0) {
+				cerr<<"direct I/O needs a block size that is a multiple of the logical block size of the device ("<<io_align<<"B)!\n"<<endl;
+				exit(1);
+			}
+		}
+
+		//a mapping always goes through the page cache, and page faults are its I/O engine
+		if (MMAP_OP(op_type) && (direct_io || engine != ENGINE_PSYNC)) {
+			cerr<<"mmap operations cannot be combined with direct I/O (-d) or io_uring (-e1)!\n"<<endl;
+			exit(1);
+		}
+
+		if (sweep_depth && engine != ENGINE_URING) {
+			cerr<<"--sweep-qd needs the io_uring engine (-e1)!\n"<<endl;
+			exit(1);
+		}
+		if (sweep_depth && sweep_mode != SWEEP_NONE) {
+			cerr<<"--sweep-qd and --sweep-threads cannot be combined!\n"<<endl;
+			exit(1);
+		}
+
+		if (sweep_mode != SWEEP_NONE && !thread_set)
+			thread_num = onlineCpus();
+
+		pinCpu = planPlacement(placement, thread_num, cpu_list);
+		if (placement != PIN_NONE && pinCpu == NULL)
+			exit(1);
+
 		/*
 		print user's input information
 		 */	
 		cout<<"\nThe benchmarking begins with:"
 			<<"\n\tOperation:\t\t"<<op[op_type]
-			<<"\n\t#Thread:\t\t"<<thread_num
+			<<"\n\t#Thread:\t\t"<<(sweep_mode == SWEEP_NONE ? to_string(thread_num) : "sweep 1 to " + to_string(thread_num) + " (" + sweep_name[sweep_mode] + ")")
+			<<"\n\tPlacement:\t\t"<<(placement == PIN_NONE ? "unpinned" : placement_name[placement] + string(" (") + cpuListString(pinCpu, thread_num) + ")")
 			<<"\n\tData size:\t\t"<<BYTE_IN_GB(data_size)<<" GB"
+			<<"\n\tEngine:\t\t\t"<<engine_name[engine]
+			<<(engine == ENGINE_PSYNC ? string("") : sweep_depth ? ", sweep queue depth 1 to " + to_string(queue_depth) : ", queue depth " + to_string(queue_depth))
+			<<"\n\tI/O:\t\t\t"<<(direct_io ? "direct (O_DIRECT, " + to_string(io_align) + "B alignment)" : string("buffered (page cache)"))
+			<<(MMAP_OP(op_type) ? ", madvise " + string(advice_name[advice]) + (populate ? ", MAP_POPULATE" : "") : string(""))
 			<<"\n\tBlock size:\t\t";
 		if (block_size < ONEKB)
 				cout<<block_size<<"B\t";
@@ -178,184 +308,626 @@ int main (int argc, char *argv[]) {
 		cout<<"\n\t#Iteration:\t\t"<<repeat_num<<endl<<endl<<endl;
 
 
-		//to reducce the memory consumption, allocating space based on benchmark purpose
-		//to accelerate speed, generating random values in advance
-		fileRangePerThrd = new size_t[thread_num];
-		fileStartPerThrd = new size_t[thread_num];
-		numOptPerThrd = new size_t[thread_num];
-
-		size_t perrange = (size_t) data_size / thread_num;
-		for (int i = 0; i < thread_num-1; i++) {
-			fileRangePerThrd[i] = perrange;
-			fileStartPerThrd[i] = i * perrange;
-			numOptPerThrd[i] = perrange / block_size;
-		}
-		fileRangePerThrd[thread_num-1] = data_size - perrange * (thread_num - 1);
-		fileStartPerThrd[thread_num-1] = perrange * (thread_num - 1);
-		numOptPerThrd[thread_num-1] = fileRangePerThrd[thread_num-1] / block_size;
-
-
 		//create the write file if it's to benchmark read+write
 		//rely on POSIX file operations to accelerate speed
-		if (op_type == RDW) {
-			if ((writeFile = open(WTFILENAME, O_WRONLY | O_CREAT  | O_NONBLOCK, (mode_t)0666)) == -1) {
+		//a shared writable mapping needs the file open for reading as well
+		if (WRITE_OP(op_type)) {
+			if ((writeFile = open(WTFILENAME, (op_type == MRW ? O_RDWR : O_WRONLY) | O_CREAT  | O_NONBLOCK, (mode_t)0666)) == -1) {
 				cerr<<"Cannot create file: "<<WTFILENAME<<endl;
 				exit(3);
 			}
 			if (skip_createfile == false) {//not skip the file creation, initialize the file content/size
-				if (lseek(writeFile, data_size-1, SEEK_SET) == -1 || write(writeFile, "", 1) < 0) {
+				//allocate the blocks up front, so the timed writes overwrite instead of allocating
+				//and stretch the file as a sparse one where the filesystem cannot fallocate
+				if (fallocate(writeFile, 0, 0, data_size) != 0
+					&& (lseek(writeFile, data_size-1, SEEK_SET) == -1 || write(writeFile, "", 1) < 0)) {
 					close(writeFile);
 					cerr<<"Cannot stretch file: "<<WTFILENAME<<" to "<<BYTE_IN_GB(data_size)<<"GB"<<endl;
 					exit(3);
 				}
+			} else if (MMAP_OP(op_type)) {		//a mapping past the end of the file faults with SIGBUS
+				struct stat wst;
+				if (fstat(writeFile, &wst) != 0 || wst.st_size < data_size) {
+					cerr<<WTFILENAME<<" is missing or smaller than "<<BYTE_IN_GB(data_size)<<"GB, run without -i to create it!"<<endl;
+					exit(3);
+				}
+			}
+			if (direct_io) {		//the one-byte stretch above cannot go through O_DIRECT
+				close(writeFile);
+				writeFile = openData(WTFILENAME, O_WRONLY);
 			}
 		} 
 		//allocate space for read buffer to store raed content for each thread
+		//page aligned, which satisfies the memory alignment of direct I/O on every device
+		//io_uring threads get queue_depth buffers each with their rings instead
 		bufferStore = new char*[thread_num];
 		for (int i = 0; i < thread_num; i++) 
-			bufferStore[i] = new char[block_size]; 
+			if (engine != ENGINE_PSYNC)
+				bufferStore[i] = NULL;
+			else if (posix_memalign((void **)&bufferStore[i], DIRECT_ALIGN, block_size) != 0) {
+				cerr<<"Cannot allocate the I/O buffers!"<<endl;
+				exit(3);
+			}
 		
 
 
-		//allocate the disk space for the file to be read, and initialize its content
-		//so firstly open the file for writing only
-		//if skip_createfile, then directly open file without initializtion
-		if (skip_createfile == false) {
-			if ((readFile = open(RDFILENAME, O_WRONLY | O_CREAT | O_NONBLOCK, (mode_t)0666)) == -1) {
-				cerr<<"Cannot create file: "<<RDFILENAME<<endl;
+		//allocate the disk space for the file to be read, and fill it with random data,
+		//unless a file of this size written by an earlier run is still there (checked with its sidecar)
+		//if skip_createfile, then directly open file without initializtion, only its size is checked
+		struct stat st;
+		if (skip_createfile) {
+			if (stat(RDFILENAME, &st) != 0 || st.st_size < data_size) {
+				cerr<<RDFILENAME<<" is missing or smaller than "<<BYTE_IN_GB(data_size)<<"GB, run without -i to create it!"<<endl;
 				exit(3);
 			}
-			// FILE* tmpreadFile;
-			// if ((tmpreadFile = fopen(RDFILENAME, "wb")) == NULL) {
-			// 	cerr<<"Cannot create file: "<<RDFILENAME<<endl;
-			// 	exit(3);
-			// }
-			//fill the read file with content '1'
-			char* tmptowrite = new char[MB_IN_BYTE(100L)];
-			memset(tmptowrite, '1', MB_IN_BYTE(100L));
-			for (int i = 0; i < data_size / MB_IN_BYTE(100L); i++) {
-				//cout<<(fwrite(tmptowrite, sizeof(char), MB_IN_BYTE(1L), tmpreadFile));
-				write(readFile, tmptowrite, MB_IN_BYTE(100L));
-			}
-			if (data_size % MB_IN_BYTE(100L) != 0) {
-				//fwrite(tmptowrite, sizeof(char), data_size % MB_IN_BYTE(1L), tmpreadFile);
-				write(readFile, tmptowrite, data_size % MB_IN_BYTE(100L));
-			}
-			//fclose(tmpreadFile);
-			close(readFile);
-			delete[] tmptowrite;
-		}
+		} else if (datasetValid(RDFILENAME, data_size))
+			cout<<"Reusing "<<RDFILENAME<<": "<<BYTE_IN_GB(data_size)<<"GB of random data, as recorded in "<<RDFILENAME<<META_SUFFIX<<endl<<endl;
+		else
+			provisionData(RDFILENAME, data_size);
 		
 		//open the file for read only
-		if ((readFile = open(RDFILENAME, O_RDONLY | O_CREAT  | O_NONBLOCK, (mode_t)0666)) == -1) {
+		if (direct_io)
+			readFile = openData(RDFILENAME, O_RDONLY);
+		else if ((readFile = open(RDFILENAME, O_RDONLY | O_CREAT  | O_NONBLOCK, (mode_t)0666)) == -1) {
 			cerr<<"Cannot open file: "<<RDFILENAME<<endl;
 			exit(3);
 		}
 
 		
-		if (op_type == RR) {		//generate random numbers in advance
-			rdmIndex = new size_t* [thread_num];
-			for (int i = 0; i < thread_num; i ++) {
-				rdmIndex[i] = new size_t[numOptPerThrd[i]];
+		ringFile[RDFILE] = readFile;
+		ringFile[WTFILE] = writeFile;
+		
+		ranCpu = new int[thread_num];
+
+		cout<<"Disk\tOpType\t#Thread\tQD\tFileSize\tBlockSize\tThroughput(MB/sec)\tIOPS\tTime(us)\tCPUs"<<endl;
+		if (sweep_depth) {
+			int max_depth = queue_depth;
+			int steps = 0;
+			int *depth = new int[32];
+			for (int d = 1; d < max_depth; d *= 2)
+				depth[steps++] = d;
+			depth[steps++] = max_depth;
+			double *rate = new double[steps];
+			for (int s = 0; s < steps; s++) {
+				queue_depth = depth[s];
+				rate[s] = runThreadCount(thread_num);
 			}
+			printDepthReport(depth, rate, steps);
+			delete[] rate;
+			delete[] depth;
+		} else if (sweep_mode == SWEEP_NONE)
+			runThreadCount(thread_num);
+		else {
+			int *counts;
+			int steps = sweepThreadCounts(sweep_mode, thread_num, &counts);
+			double *rate = new double[steps];
+			for (int s = 0; s < steps; s++)
+				rate[s] = runThreadCount(counts[s]);
+			printScalingReport(counts, rate, steps, "MB/s");
+			delete[] rate;
+			delete[] counts;
 		}
 
 
+		for (int i = 0; i < thread_num; i++)
+			free(bufferStore[i]);
+		delete[] bufferStore;
 
-		//float *runtime = (float *) malloc (sizeof(float) * repeat_num); 
-		float *runtime = new float[repeat_num];
+		delete[] pinCpu;
+		delete[] ranCpu;
 
-		cout<<"Disk\tOpType\t#Thread\tFileSize\tBlockSize\tThroughput(MB/sec)\tLatency(us)"<<endl;
-		for (int i = 0; i < repeat_num; i++) {
-			if (op_type == RR) {
-				for (int j = 0; j < thread_num; j++) {
-					random_device rd;		//obtain a seed for the random number engine
-					mt19937 gen(rd());		//mersenne_twister_engine seeded
-					uniform_int_distribution<size_t> dis(0, fileRangePerThrd[i] - 1 - block_size);	//uniform distribution
-					for (int k = 0; k < numOptPerThrd[j]; k++) {
-						rdmIndex[i][j] = dis(gen);
-					}
-				}
+		return 0;
+
+}
+
+
+
+/**
+ * split the file among n threads and run the benchmark repeat_num times on a pool of n workers
+ * the workers are pinned to the first n CPUs of the placement
+ * @param  n thread count
+ * @return   best throughput of the repeats, in MB/s
+ */
+double runThreadCount (int n) {
+	thread_num = n;
+
+	//to reducce the memory consumption, allocating space based on benchmark purpose
+	//to accelerate speed, generating random values in advance
+	fileRangePerThrd = new size_t[thread_num];
+	fileStartPerThrd = new size_t[thread_num];
+	numOptPerThrd = new size_t[thread_num];
+
+	size_t perrange = (size_t) data_size / thread_num;
+	perrange -= perrange % io_align;		//direct I/O: every thread starts on a logical block
+	for (int i = 0; i < thread_num-1; i++) {
+		fileRangePerThrd[i] = perrange;
+		fileStartPerThrd[i] = i * perrange;
+		numOptPerThrd[i] = perrange / block_size;
+	}
+	fileRangePerThrd[thread_num-1] = data_size - perrange * (thread_num - 1);
+	fileStartPerThrd[thread_num-1] = perrange * (thread_num - 1);
+	numOptPerThrd[thread_num-1] = fileRangePerThrd[thread_num-1] / block_size;
+
+
+
+	//float *runtime = (float *) malloc (sizeof(float) * repeat_num); 
+	float *runtime = new float[repeat_num];
+	double best = 0;
+	if (engine == ENGINE_URING)
+		ringsCreate();
+	readHist = new latency_hist[thread_num];
+	writeHist = new latency_hist[thread_num];
+	poolCreate(thread_num, pinCpu);
+	double *thrdMB = new double[thread_num];		//data moved by each thread, for the per-thread report
+	double totalMB = 0;		//data moved by all threads, whole blocks only, which can fall short of data_size
+	for (int i = 0; i < thread_num; i++) {
+		thrdMB[i] = BYTE_IN_MB(numOptPerThrd[i] * block_size);
+		totalMB += thrdMB[i];
+	}
+
+	for (int i = 0; i < repeat_num; i++) {
+		//faults of the timed run only: a fresh mapping per repeat, set up (and populated) before the clock starts
+		if (MMAP_OP(op_type))
+			mapData();
+		struct rusage before, after;
+		getrusage(RUSAGE_SELF, &before);
+		for (int j = 0; j < thread_num; j++) {
+			histReset(&readHist[j]);
+			histReset(&writeHist[j]);
+		}
+		runtime[i] = disk_benchmark();
+		getrusage(RUSAGE_SELF, &after);
+		if (MMAP_OP(op_type))
+			unmapData();
+		if (totalMB / runtime[i] > best)
+			best = totalMB / runtime[i];
+		cout<<"#Iter "<<i<<"\t"<<op[op_type]<<"\t"<<thread_num
+			<<"\t"<<(engine == ENGINE_PSYNC ? 1 : queue_depth)
+			<<"\t"<<BYTE_IN_GB(data_size)<<"GB\t";
+
+		if (block_size < ONEKB)
+			cout<<block_size<<"B\t";
+		else if (block_size < ONEMB)
+			cout<<BYTE_IN_KB(block_size)<<"KB\t";
+		else if (block_size < ONEGB)
+			cout<<BYTE_IN_MB(block_size)<<"MB\t";
+		else
+			cout<<BYTE_IN_GB(block_size)<<"GB\t";
+
+		cout<<totalMB/runtime[i]<<"MB/s\t"
+			<<(long)iopsOf(totalMB/runtime[i])<<"\t"
+			<<runtime[i]*1e6<<"us\t"<<cpuListString(ranCpu, thread_num)<<endl;
+		long majflt = after.ru_majflt - before.ru_majflt, minflt = after.ru_minflt - before.ru_minflt;
+		cout<<"\tPage faults\tmajor "<<majflt<<"\tminor "<<minflt
+			<<"\t"<<(majflt + minflt) / totalMB<<" per MB"<<endl;
+		printLatencyReport(readHist, "read", i);
+		printLatencyReport(writeHist, "write", i);
+		printThreadReport(thrdMB, "MB/s", ranCpu);
+
+			
+	}
+
+
+	poolDestroy();
+	if (engine == ENGINE_URING)
+		ringsDestroy();
+	delete[] readHist;
+	delete[] writeHist;
+	delete[] thrdMB;
+	delete[] runtime;
+
+	delete[] fileRangePerThrd;
+	delete[] fileStartPerThrd;
+	delete[] numOptPerThrd;
+
+	return best;
+}
+
+
+/**
+ * I/O operations per second at a bandwidth, a read and a write count as two
+ * @param  mbps bandwidth in MB/s over the blocks transferred
+ * @return      IOPS
+ */
+double iopsOf (double mbps) {
+	return mbps * ONEMB / block_size * (WRITE_OP(op_type) ? 2 : 1);
+}
+
+
+
+/**
+ * merge the per-thread latency histograms of a run and print min, mean, percentiles and max,
+ * and dump the merged histogram to --hist-file
+ * nothing is printed for a kind of I/O the operation does not do
+ * @param hist one histogram per thread
+ * @param kind "read" or "write"
+ * @param iter repeat number, for the dump
+ */
+void printLatencyReport (const latency_hist *hist, const char *kind, int iter) {
+	latency_hist all;
+	histReset(&all);
+	for (int i = 0; i < thread_num; i++)
+		histMerge(&all, &hist[i]);
+	if (all.total == 0)
+		return;
+	cout<<"\t"<<kind<<" latency(us)\tmin "<<all.min / 1e3<<"\tmean "<<histMean(&all) / 1e3;
+	double pct[] = {50, 90, 99, 99.9};
+	for (int p = 0; p < 4; p++)
+		cout<<"\tp"<<pct[p]<<" "<<histPercentile(&all, pct[p]) / 1e3;
+	cout<<"\tmax "<<all.max / 1e3<<endl;
+
+	if (histOut.is_open()) {
+		histOut<<"# "<<op[op_type]<<", "<<kind<<", "<<thread_num<<" thread(s), queue depth "<<(engine == ENGINE_PSYNC ? 1 : queue_depth)
+			<<", block size "<<block_size<<"B, iteration "<<iter<<endl;
+		histDump(&all, histOut);
+		histOut<<endl;
+	}
+}
+
+
+
+/**
+ * set up one io_uring per thread with queue_depth page-aligned buffers,
+ * and register the buffers and both files with it, so requests skip the page pinning and file lookup
+ * registration is an optimisation only: without it the same buffers and descriptors are used in plain requests
+ */
+void ringsCreate () {
+	rings = new uring[thread_num];
+	slotBuf = new char**[thread_num];
+	bool fixed = true;
+	for (int i = 0; i < thread_num; i++) {
+		if (!uringInit(&rings[i], queue_depth)) {
+			cerr<<"Cannot set up io_uring ("<<strerror(errno)<<"), it needs Linux 5.6 and must not be disabled"
+				<<" (/proc/sys/kernel/io_uring_disabled), use -e0!"<<endl;
+			exit(3);
+		}
+		slotBuf[i] = new char*[queue_depth];
+		for (int s = 0; s < queue_depth; s++)
+			if (posix_memalign((void **)&slotBuf[i][s], DIRECT_ALIGN, block_size) != 0) {
+				cerr<<"Cannot allocate the I/O buffers!"<<endl;
+				exit(3);
 			}
+		fixed &= uringRegisterBuffers(&rings[i], slotBuf[i], queue_depth, block_size);
+		fixed &= uringRegisterFiles(&rings[i], ringFile, op_type == RDW ? 2 : 1);
+	}
+	if (!fixed)
+		cerr<<"io_uring: cannot register buffers or files (RLIMIT_MEMLOCK?), using plain requests"<<endl;
+}
 
-			runtime[i] = disk_benchmark();
-			cout<<"#Iter "<<i<<"\t"<<op[op_type]<<"\t"<<thread_num
-				<<"\t"<<BYTE_IN_GB(data_size)<<"GB\t";
 
-			if (block_size < ONEKB)
-				cout<<block_size<<"B\t";
-			else if (block_size < ONEMB)
-				cout<<BYTE_IN_KB(block_size)<<"KB\t";
-			else if (block_size < ONEGB)
-				cout<<BYTE_IN_MB(block_size)<<"MB\t";
-			else
-				cout<<BYTE_IN_GB(block_size)<<"GB\t";
 
-			cout<<BYTE_IN_MB(data_size)/runtime[i]<<"MB/s\t"
-				<<runtime[i]*1e6<<"us"<<endl;
+/**
+ * tear down the rings and free their buffers
+ */
+void ringsDestroy () {
+	for (int i = 0; i < thread_num; i++) {
+		uringExit(&rings[i]);
+		for (int s = 0; s < queue_depth; s++)
+			free(slotBuf[i][s]);
+		delete[] slotBuf[i];
+	}
+	delete[] slotBuf;
+	delete[] rings;
+}
 
-				
+
+
+/**
+ * print IOPS and bandwidth against the queue depth of a --sweep-qd run
+ * @param depth queue depth of every step
+ * @param rate  best bandwidth of every step, MB/s
+ * @param n     number of steps
+ */
+void printDepthReport (const int *depth, const double *rate, int n) {
+	cout<<endl<<"Queue depth scaling ("<<thread_num<<" thread(s), "<<op[op_type]<<")"<<endl;
+	cout<<"QD\tIOPS\tMB/s\tvs QD"<<depth[0]<<endl;
+	for (int i = 0; i < n; i++)
+		cout<<depth[i]<<"\t"<<(long)iopsOf(rate[i])<<"\t"<<rate[i]<<"\t"<<rate[i] / rate[0]<<"x"<<endl;
+}
+
+
+
+/**
+ * xorshift64* seeded with splitmix64, one generator per thread
+ * random data of the test file: seeded with (seed, writer), incompressible and unique per block,
+ * so neither compression nor deduplication of the storage shrinks it
+ * random offsets: seeded with (run, thread) and drawn inline, so every repeat and thread gets its own stream
+ * and no offset tables are built
+ */
+static inline uint64_t splitmix64 (uint64_t x) {
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+static inline uint64_t xorshift64s (uint64_t &state) {
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * random block start in a thread's range, a multiple of io_align so direct I/O stays aligned (bytes when buffered)
+ * a draw x maps to [0, n) as the high half of x * n, which needs no division
+ */
+static inline off_t rdmOffset (int id, uint64_t &state) {
+	uint64_t n = (fileRangePerThrd[id] - block_size) / io_align + 1;		//aligned starts where a whole block fits
+	return fileStartPerThrd[id] + (off_t)(((unsigned __int128)xorshift64s(state) * n) >> 64) * io_align;
+}
+
+
+
+/**
+ * whether a test file left by an earlier run can be reused: its sidecar must name the same size and pattern,
+ * and the file must still have that size and the modification time recorded when it was written
+ * @param  name file name, the sidecar is name + META_SUFFIX
+ * @param  size bytes the run needs
+ * @return      true if the file is complete and unchanged
+ */
+bool datasetValid (const char *name, long size) {
+	struct stat st;
+	if (stat(name, &st) != 0 || st.st_size != size)
+		return false;
+	ifstream meta(string(name) + META_SUFFIX);
+	string tag, pattern;
+	int version;
+	long msize, msec, mnsec;
+	uint64_t seed;
+	if (!(meta>>tag>>version) || tag != META_TAG || version != META_VERSION)
+		return false;
+	if (!(meta>>tag>>msize) || tag != "size" || !(meta>>tag>>pattern) || tag != "pattern"
+		|| !(meta>>tag>>seed) || tag != "seed" || !(meta>>tag>>msec>>mnsec) || tag != "mtime")
+		return false;
+	return msize == size && pattern == META_PATTERN && msec == st.st_mtim.tv_sec && mnsec == st.st_mtim.tv_nsec;
+}
+
+
+
+/**
+ * create a test file of random data with a pool of writers, and record it in its sidecar
+ * the blocks are allocated with fallocate first, so the writers fill an extent instead of growing the file,
+ * every writer fills its own range in PROVISION_CHUNK writes and finishes short writes
+ * the file is synced and dropped from the page cache, so the first run does not start on a cached file
+ * @param name file name
+ * @param size bytes
+ */
+void provisionData (const char *name, long size) {
+	unlink((string(name) + META_SUFFIX).c_str());		//no stale sidecar if the provisioning is interrupted
+	if ((fillFile = open(name, O_WRONLY | O_CREAT, (mode_t)0666)) == -1) {
+		cerr<<"Cannot create file: "<<name<<endl;
+		exit(3);
+	}
+	if (ftruncate(fillFile, size) != 0) {
+		cerr<<"Cannot resize file: "<<name<<" to "<<BYTE_IN_GB(size)<<"GB ("<<strerror(errno)<<")"<<endl;
+		exit(3);
+	}
+	bool allocated = (fallocate(fillFile, 0, 0, size) == 0);
+
+	int writers = onlineCpus() < PROVISION_WRITERS ? onlineCpus() : PROVISION_WRITERS;
+	long chunks = (size + PROVISION_CHUNK - 1) / PROVISION_CHUNK;
+	if (writers > chunks)
+		writers = chunks;
+	fillStart = new long[writers + 1];
+	fillErr = new int[writers];
+	for (int i = 0; i <= writers; i++)
+		fillStart[i] = i < writers ? chunks * i / writers * PROVISION_CHUNK : size;
+	fill_seed = histNow();
+
+	uint64_t t0 = histNow();
+	poolCreate(writers, NULL);
+	poolRun(fillData);
+	poolDestroy();
+	for (int i = 0; i < writers; i++)
+		if (fillErr[i] != 0) {
+			cerr<<"Cannot write file: "<<name<<" ("<<strerror(fillErr[i])<<")"<<endl;
+			exit(3);
 		}
+	if (fsync(fillFile) != 0) {
+		cerr<<"Cannot sync file: "<<name<<" ("<<strerror(errno)<<")"<<endl;
+		exit(3);
+	}
+	posix_fadvise(fillFile, 0, size, POSIX_FADV_DONTNEED);
+	close(fillFile);
+	double seconds = (histNow() - t0) / 1e9;
+	cout<<"Created "<<name<<": "<<BYTE_IN_GB(size)<<"GB of random data"<<(allocated ? " (fallocated)" : "")
+		<<" with "<<writers<<" writer(s) in "<<seconds<<"s, "<<BYTE_IN_MB(size) / seconds<<"MB/s"<<endl<<endl;
+	delete[] fillStart;
+	delete[] fillErr;
+
+	struct stat st;
+	stat(name, &st);
+	ofstream meta(string(name) + META_SUFFIX);
+	meta<<META_TAG<<" "<<META_VERSION<<endl
+		<<"size "<<size<<endl
+		<<"pattern "<<META_PATTERN<<endl
+		<<"seed "<<fill_seed<<endl
+		<<"mtime "<<st.st_mtim.tv_sec<<" "<<st.st_mtim.tv_nsec<<endl;
+}
 
 
-		delete[] runtime;
 
-		if (op_type == RR) {
-			for (int i = 0; i < thread_num; i++)
-				delete[] rdmIndex[i];
-			delete[] rdmIndex;
+/**
+ * test file writer: fills its range of the file with random data, chunk by chunk
+ * @param  argv writer ID
+ * @return      NULL, the errno of a failed write in fillErr
+ */
+void *fillData (void *argv) {
+	int crtThrdID = *(int *)argv;
+	fillErr[crtThrdID] = 0;
+	uint64_t *chunk = new uint64_t[PROVISION_CHUNK / sizeof(uint64_t)];
+	uint64_t state = splitmix64(fill_seed + crtThrdID) | 1;		//xorshift state must not be 0
+	for (long off = fillStart[crtThrdID]; off < fillStart[crtThrdID + 1]; off += PROVISION_CHUNK) {
+		for (size_t k = 0; k < PROVISION_CHUNK / sizeof(uint64_t); k++)
+			chunk[k] = xorshift64s(state);
+		long len = fillStart[crtThrdID + 1] - off < PROVISION_CHUNK ? fillStart[crtThrdID + 1] - off : PROVISION_CHUNK;
+		for (long done = 0; done < len; ) {
+			ssize_t n = pwrite(fillFile, (char *)chunk + done, len - done, off + done);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0) {
+				fillErr[crtThrdID] = n < 0 ? errno : ENOSPC;
+				delete[] chunk;
+				return NULL;
+			}
+			done += n;
 		}
-		for (int i = 0; i < thread_num; i++)
-			delete[] bufferStore[i];
-		delete[] bufferStore;
+	}
+	delete[] chunk;
+	return NULL;
+}
 
-		delete[] fileRangePerThrd;
-		delete[] fileStartPerThrd;
-		delete[] numOptPerThrd;
 
-		return 0;
 
+/**
+ * map the files for a repeat of an mmap operation, with the madvise hint
+ * MAP_POPULATE reads the whole file into the page cache and the page tables here, before the timed run
+ */
+void mapData () {
+	int flags = MAP_SHARED | (populate ? MAP_POPULATE : 0);
+	int hint[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED};
+	if ((readMap = (char *)mmap(NULL, data_size, PROT_READ, flags, readFile, 0)) == MAP_FAILED) {
+		cerr<<"Cannot map file: "<<RDFILENAME<<" ("<<strerror(errno)<<")"<<endl;
+		exit(3);
+	}
+	madvise(readMap, data_size, hint[advice]);
+	if (op_type == MRW) {
+		if ((writeMap = (char *)mmap(NULL, data_size, PROT_READ | PROT_WRITE, flags, writeFile, 0)) == MAP_FAILED) {
+			cerr<<"Cannot map file: "<<WTFILENAME<<" ("<<strerror(errno)<<")"<<endl;
+			exit(3);
+		}
+		madvise(writeMap, data_size, hint[advice]);
+	}
+}
+
+
+
+/**
+ * unmap the files after a repeat, the next one faults its pages in again
+ */
+void unmapData () {
+	munmap(readMap, data_size);
+	if (op_type == MRW)
+		munmap(writeMap, data_size);
 }
 
 
+
+/**
+ * offset and size alignment of direct I/O on the filesystem of a path,
+ * the logical block size of its block device from /sys/dev/block/<major>:<minor>
+ * a partition has no queue directory of its own, its parent disk has
+ * @param  path file or directory on the filesystem
+ * @return      bytes, DIRECT_ALIGN if sysfs does not tell
+ */
+long directAlignment (const char *path) {
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return DIRECT_ALIGN;
+	string dev = "/sys/dev/block/" + to_string(major(st.st_dev)) + ":" + to_string(minor(st.st_dev));
+	long size = 0;
+	ifstream in(dev + "/queue/logical_block_size");
+	if (!(in>>size)) {
+		ifstream parent(dev + "/../queue/logical_block_size");
+		if (!(parent>>size))
+			return DIRECT_ALIGN;
+	}
+	return size > 0 ? size : DIRECT_ALIGN;
+}
+
+
+
+/**
+ * open a data file with O_DIRECT, and without it if the filesystem refuses direct I/O
+ * some filesystems (tmpfs, some FUSE and network filesystems) reject O_DIRECT at open with EINVAL,
+ * others accept the flag and fail the first transfer, so one aligned block is read (or written) as a probe
+ * clears direct_io and io_align on fallback, so the run uses buffered I/O from then on
+ * @param  name  file name
+ * @param  flags O_RDONLY or O_WRONLY
+ * @return       file descriptor, exits if the file cannot be opened at all
+ */
+int openData (const char *name, int flags) {
+	int fd = open(name, flags | O_CREAT | O_DIRECT, (mode_t)0666);
+	if (fd != -1) {
+		char *probe;
+		if (posix_memalign((void **)&probe, DIRECT_ALIGN, io_align) != 0) {
+			cerr<<"Cannot allocate the I/O buffers!"<<endl;
+			exit(3);
+		}
+		memset(probe, 0, io_align);
+		ssize_t done = flags == O_RDONLY ? pread(fd, probe, io_align, 0) : pwrite(fd, probe, io_align, 0);
+		if (done < 0 && errno == EINVAL) {
+			close(fd);
+			fd = -1;
+			errno = EINVAL;
+		}
+		free(probe);
+	}
+	if (fd == -1 && errno == EINVAL) {
+		cerr<<"O_DIRECT is not supported by the filesystem of "<<name<<", falling back to buffered I/O:"<<endl
+			<<"\tthe results include the page cache, run in a directory on the device to measure it"<<endl;
+		direct_io = false;
+		io_align = 1;
+		fd = open(name, flags | O_CREAT, (mode_t)0666);
+	}
+	if (fd == -1) {
+		cerr<<"Cannot open file: "<<name<<" ("<<strerror(errno)<<")"<<endl;
+		exit(3);
+	}
+	return fd;
+}
+
+
+
 /**
  * disk benchmark implementation
  * @return running time in seconds
  */
 double disk_benchmark () {
-	struct timeval starttime, endtime;
-	long runtime;
-	pthread_t *threads = new pthread_t [thread_num];
-	int* thrdID = new int[thread_num];
-	for (int i = 0; i < thread_num; i++)
-		thrdID[i] = i; 
-
-	gettimeofday(&starttime, NULL);
-	if (op_type == RDW) {
-		for (int tid = 0; tid < thread_num; tid++)
-			//pthread_create(&threads[tid], NULL, readWrite, (void *)&tid);
-			pthread_create(&threads[tid], NULL, readWrite, (void *)(thrdID + tid));
-	} else if (op_type == SR) {
-		for (int tid = 0; tid < thread_num; tid++)
-			pthread_create(&threads[tid], NULL, sqtialRead, (void *)(thrdID + tid));
-	} else if (op_type == RR) {
-		for (int tid = 0; tid < thread_num; tid++)
-			pthread_create(&threads[tid], NULL, rdmRead, (void *)(thrdID + tid));
-	} else {
-		cerr<<"Invalid structions! opType can only be 0,1,2!"<<endl;
-		abort();
-	}
-	for (int i = 0; i < thread_num; i++) {
-		pthread_join(threads[i], NULL);
-	}
-	gettimeofday(&endtime, NULL);
+	run_id++;
+	//workers already exist, only barrier release to last finish is timed
+	if (engine == ENGINE_URING)
+		return poolRun(uringIO);
+	else if (op_type == RDW)
+		return poolRun(readWrite);
+	else if (op_type == SR)
+		return poolRun(sqtialRead);
+	else if (op_type == RR)
+		return poolRun(rdmRead);
+	else if (op_type == MRW)
+		return poolRun(mmapReadWrite);
+	else if (op_type == MSR)
+		return poolRun(mmapSqtialRead);
+	else if (op_type == MRR)
+		return poolRun(mmapRdmRead);
+
+	cerr<<"Invalid structions! opType can only be 0 to 5!"<<endl;
+	abort();
+}
 
-	delete[] threads;
-	delete[] thrdID;
-	
-	runtime = (endtime.tv_sec - starttime.tv_sec) * 1000000L + (endtime.tv_usec - starttime.tv_usec);	//time in microsecond
-	return runtime/1000000.0;	//time in seconds 
 
+
+/**
+ * pread or pwrite a whole block, like uringIO: a short transfer continues with the rest of the block,
+ * a failure or the end of the file ends the run, so no block is counted that was not transferred
+ * @param write write if true, read otherwise
+ * @param fd    file descriptor
+ * @param buf   block buffer
+ * @param off   file offset of the block
+ */
+static inline void blockIO (bool write, int fd, char *buf, off_t off) {
+	for (long moved = 0; moved < block_size; ) {
+		ssize_t n = write ? pwrite(fd, buf + moved, block_size - moved, off + moved)
+			: pread(fd, buf + moved, block_size - moved, off + moved);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			cerr<<(write ? "pwrite" : "pread")<<" at "<<off + moved<<" failed: "<<(n < 0 ? strerror(errno) : "end of file")<<endl;
+			exit(3);
+		}
+		moved += n;
+	}
 }
 
 
@@ -366,11 +938,18 @@ double disk_benchmark () {
  */
 void *readWrite (void *argv) {
 	int crtThrdID = *(int *)argv;
+	latency_hist *rh = &readHist[crtThrdID], *wh = &writeHist[crtThrdID];
+	uint64_t t0 = histNow(), t1;		//one time stamp per I/O, the end of one is the start of the next
 	for (size_t i = 0; i < numOptPerThrd[crtThrdID]; i++) {
-		pread(readFile, bufferStore[crtThrdID], block_size, fileStartPerThrd[crtThrdID]+i*block_size);
-		pwrite(writeFile, bufferStore[crtThrdID], block_size, fileStartPerThrd[crtThrdID]+i*block_size);
+		blockIO(false, readFile, bufferStore[crtThrdID], fileStartPerThrd[crtThrdID]+i*block_size);
+		t1 = histNow();
+		histRecord(rh, t1 - t0);
+		blockIO(true, writeFile, bufferStore[crtThrdID], fileStartPerThrd[crtThrdID]+i*block_size);
+		t0 = histNow();
+		histRecord(wh, t0 - t1);
 	}
 
+	ranCpu[crtThrdID] = sched_getcpu();
 	return NULL;
 }
 
@@ -382,9 +961,15 @@ void *readWrite (void *argv) {
  */
 void *sqtialRead (void *argv) {
 	int crtThrdID = *(int *)argv;
+	latency_hist *rh = &readHist[crtThrdID];
+	uint64_t t0 = histNow(), t1;
 	for (size_t i = 0; i < numOptPerThrd[crtThrdID]; i++) {
-		pread(readFile, bufferStore[crtThrdID], block_size, fileStartPerThrd[crtThrdID]+i*block_size);
+		blockIO(false, readFile, bufferStore[crtThrdID], fileStartPerThrd[crtThrdID]+i*block_size);
+		t1 = histNow();
+		histRecord(rh, t1 - t0);
+		t0 = t1;
 	}
+	ranCpu[crtThrdID] = sched_getcpu();
 	return NULL;
 }
 
@@ -395,14 +980,173 @@ void *sqtialRead (void *argv) {
  */
 void *rdmRead (void *argv) {
 	int crtThrdID = *(int *)argv;
+	latency_hist *rh = &readHist[crtThrdID];
+	uint64_t state = splitmix64(run_id * thread_num + crtThrdID) | 1;		//xorshift state must not be 0
+	uint64_t t0 = histNow(), t1;
 	for (size_t i = 0; i < numOptPerThrd[crtThrdID]; i++) {
-		pread(readFile, bufferStore[crtThrdID], block_size, fileStartPerThrd[crtThrdID] + rdmIndex[crtThrdID][i]);
+		blockIO(false, readFile, bufferStore[crtThrdID], rdmOffset(crtThrdID, state));
+		t1 = histNow();
+		histRecord(rh, t1 - t0);
+		t0 = t1;
 	}
+	ranCpu[crtThrdID] = sched_getcpu();
 	return NULL;
 
 }
 
 
 
+/**
+ * mmap sequential read and write benchmark, every block copied from the read mapping to the write mapping
+ * the thread's range is flushed with msync before it finishes, so the write-back is part of the run
+ * the copy of a block, faults of both mappings included, is its write latency, the msync is not in the histogram
+ * @param  argv thread ID
+ * @return      [description]
+ */
+void *mmapReadWrite (void *argv) {
+	int crtThrdID = *(int *)argv;
+	latency_hist *wh = &writeHist[crtThrdID];
+	size_t start = fileStartPerThrd[crtThrdID];
+	uint64_t t0 = histNow(), t1;
+	for (size_t i = 0; i < numOptPerThrd[crtThrdID]; i++) {
+		memcpy(writeMap + start + i * block_size, readMap + start + i * block_size, block_size);
+		t1 = histNow();
+		histRecord(wh, t1 - t0);
+		t0 = t1;
+	}
 
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t aligned = start / page * page;		//msync needs a page-aligned address
+	msync(writeMap + aligned, start - aligned + numOptPerThrd[crtThrdID] * block_size, MS_SYNC);
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+/**
+ * mmap sequential read benchmark, every block copied out of the mapping like pread copies it out of the page cache
+ * @param  argv thread ID
+ * @return      [description]
+ */
+void *mmapSqtialRead (void *argv) {
+	int crtThrdID = *(int *)argv;
+	latency_hist *rh = &readHist[crtThrdID];
+	uint64_t t0 = histNow(), t1;
+	for (size_t i = 0; i < numOptPerThrd[crtThrdID]; i++) {
+		memcpy(bufferStore[crtThrdID], readMap + fileStartPerThrd[crtThrdID] + i * block_size, block_size);
+		t1 = histNow();
+		histRecord(rh, t1 - t0);
+		t0 = t1;
+	}
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
 
+/**
+ * mmap random read benchmark
+ * @param  argv thread ID
+ * @return      [description]
+ */
+void *mmapRdmRead (void *argv) {
+	int crtThrdID = *(int *)argv;
+	latency_hist *rh = &readHist[crtThrdID];
+	uint64_t state = splitmix64(run_id * thread_num + crtThrdID) | 1;
+	uint64_t t0 = histNow(), t1;
+	for (size_t i = 0; i < numOptPerThrd[crtThrdID]; i++) {
+		memcpy(bufferStore[crtThrdID], readMap + rdmOffset(crtThrdID, state), block_size);
+		t1 = histNow();
+		histRecord(rh, t1 - t0);
+		t0 = t1;
+	}
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+
+/**
+ * file offset of the k-th block of a thread, in the order of the operation type
+ * @param  id    thread ID
+ * @param  k     block number
+ * @param  state random offsets: the thread's generator
+ * @return       offset in bytes
+ */
+static inline off_t ioOffset (int id, size_t k, uint64_t &state) {
+	return op_type == RR ? rdmOffset(id, state) : fileStartPerThrd[id] + k * block_size;
+}
+
+
+
+/**
+ * io_uring benchmark of every operation type, with queue_depth requests in flight
+ * every buffer slot carries one block: read, for read&write then written back to the same offset, then refilled
+ * the refills of all completions reaped are submitted together with the wait for the next one, one system call per batch
+ * a request's latency runs from the submission of its batch to the return of the io_uring_enter that reaped it,
+ * two time stamps per batch rather than per request
+ * a short transfer is resubmitted for the rest of the block, and the block only counts once it is complete
+ * @param  argv thread ID
+ * @return      [description]
+ */
+void *uringIO (void *argv) {
+	int crtThrdID = *(int *)argv;
+	uring *r = &rings[crtThrdID];
+	char **buf = slotBuf[crtThrdID];
+	size_t n = numOptPerThrd[crtThrdID];
+	size_t issued = 0, done = 0;
+	latency_hist *rh = &readHist[crtThrdID], *wh = &writeHist[crtThrdID];
+	off_t offset[URING_MAXDEPTH];		//offset of the block in every slot
+	long moved[URING_MAXDEPTH];		//bytes of the current request of every slot transferred so far
+	uint64_t sent[URING_MAXDEPTH];		//submission time of the request in every slot
+	int fresh[URING_MAXDEPTH];		//slots prepared since the last submission
+	int nfresh = 0;
+	uint64_t state = splitmix64(run_id * thread_num + crtThrdID) | 1;
+
+	for (int s = 0; s < queue_depth && issued < n; s++, issued++) {
+		offset[s] = ioOffset(crtThrdID, issued, state);
+		moved[s] = 0;
+		uringPrep(r, false, RDFILE, buf[s], s, block_size, offset[s], s);
+		fresh[nfresh++] = s;
+	}
+	while (done < n) {
+		uint64_t now = histNow();
+		for (int k = 0; k < nfresh; k++)
+			sent[fresh[k]] = now;
+		nfresh = 0;
+		int ret = uringSubmit(r, 1);
+		if (ret < 0) {
+			cerr<<"io_uring_enter failed: "<<strerror(-ret)<<endl;
+			exit(3);
+		}
+		now = histNow();
+		uint64_t data;
+		int res;
+		while (uringReap(r, &data, &res)) {
+			int s = data & URING_SLOT;
+			bool write = data & URING_WRITE;
+			if (res <= 0) {
+				cerr<<"io_uring "<<(write ? "write" : "read")<<" at "<<offset[s] + moved[s]<<" failed: "
+					<<(res < 0 ? strerror(-res) : "end of file")<<endl;
+				exit(3);
+			}
+			if ((moved[s] += res) < block_size) {		//short transfer, the rest keeps its submission time
+				uringPrep(r, write, write ? WTFILE : RDFILE, buf[s] + moved[s], s, block_size - moved[s], offset[s] + moved[s], data);
+				continue;
+			}
+			moved[s] = 0;
+			histRecord(write ? wh : rh, now - sent[s]);
+			if (op_type == RDW && !write) {
+				uringPrep(r, true, WTFILE, buf[s], s, block_size, offset[s], s | URING_WRITE);
+				fresh[nfresh++] = s;
+				continue;
+			}
+			done++;
+			if (issued < n) {
+				offset[s] = ioOffset(crtThrdID, issued++, state);
+				uringPrep(r, false, RDFILE, buf[s], s, block_size, offset[s], s);
+				fresh[nfresh++] = s;
+			}
+		}
+	}
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
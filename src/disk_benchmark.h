@@ -4,11 +4,32 @@
 #include <cstddef>
 //#include <cstdio>
 #include <string>
+#include <fstream>
+#include "affinity.h"
+#include "worker_pool.h"
+#include "scaling.h"
+#include "uring.h"
+#include "latency_hist.h"
 
 
 #define RDW 0	//read and write
 #define SR 1	//Sequantial read
 #define RR	2	//random raed
+#define MSR 3	//mmap sequential read
+#define MRR 4	//mmap random read
+#define MRW 5	//mmap sequential read and write
+
+#define MMAP_OP(OP) ((OP) >= MSR)		//operation through a mapping of the files
+#define WRITE_OP(OP) ((OP) == RDW || (OP) == MRW)		//operation that also writes towrite.bin
+#define RANDOM_OP(OP) ((OP) == RR || (OP) == MRR)		//operation at random offsets
+
+#define ADV_NONE 0		//mmap: no madvise hint, kernel default readahead
+#define ADV_SEQUENTIAL 1	//mmap: MADV_SEQUENTIAL, aggressive readahead, pages dropped behind
+#define ADV_RANDOM 2	//mmap: MADV_RANDOM, no readahead
+#define ADV_WILLNEED 3	//mmap: MADV_WILLNEED, read the whole file ahead
+
+#define ENGINE_PSYNC 0	//one blocking pread/pwrite at a time per thread
+#define ENGINE_URING 1	//io_uring, queue_depth requests in flight per thread
 
 #define LTC 0	//latency
 #define THRPT 1	//throughput
@@ -31,15 +52,36 @@
 #define BYTE_IN_GB(B) ((double)B/ONEGB)	//Bytes in GB
 
 #define DEFAULTDATASIZE GB_IN_BYTE(10L)		//10GB
+#define DIRECT_ALIGN 4096L		//direct I/O: alignment if sysfs has no logical block size, buffers are always page aligned
+
+#define PROVISION_CHUNK MB_IN_BYTE(4L)		//test file: bytes per write of a writer
+#define PROVISION_WRITERS 16		//test file: most writers
+#define META_SUFFIX ".meta"		//test file: sidecar recording size, pattern and modification time
+#define META_TAG "hwbench-dataset"
+#define META_VERSION 1
+#define META_PATTERN "xorshift64*"
+
+#define DEFAULTDEPTH 32		//io_uring: requests in flight per thread
+#define QD_SWEEP_OPT 257		//getopt_long value of --sweep-qd, next to SWEEP_OPT
+#define POPULATE_OPT 258		//getopt_long value of --populate
+#define HIST_OPT 259		//getopt_long value of --hist-file
+#define URING_WRITE (1UL << 16)		//io_uring: user data tag of a write, the low bits hold the buffer slot
+#define URING_SLOT (URING_WRITE - 1)
+#define RDFILE 0		//io_uring: index of the read file among the ring's files
+#define WTFILE 1		//io_uring: index of the write file
 
 typedef int OP_TYPE;		//operation type
 typedef int METRIC;		//metric
+typedef int ENGINE;		//I/O engine
+typedef int ADVICE;		//mmap: madvise hint
 
-const int MAXTHREADS = 20;
 const long MINDATASIZE = GB_IN_BYTE(1L);
 const long MAXBLOCKSIZE = MB_IN_BYTE(100L);
 
-const char* op[] = {"Sequential Read&Write", "Sequential Read", "Random Read"};
+const char* op[] = {"Sequential Read&Write", "Sequential Read", "Random Read",
+	"mmap Sequential Read", "mmap Random Read", "mmap Sequential Read&Write"};
+const char* engine_name[] = {"psync", "io_uring"};
+const char* advice_name[] = {"none", "MADV_SEQUENTIAL", "MADV_RANDOM", "MADV_WILLNEED"};
 
 const char* RDFILENAME = "toread.bin";
 const char* WTFILENAME = "towrite.bin";
@@ -50,31 +92,78 @@ global variables
 OP_TYPE op_type = RDW;
 METRIC metric = THRPT;
 bool skip_createfile = false;
+bool direct_io = false;		//O_DIRECT, bypass the page cache, default = buffered
+long io_align = 1;		//direct I/O: offset and size alignment, the logical block size of the device
+ENGINE engine = ENGINE_PSYNC;
+int queue_depth = DEFAULTDEPTH;		//io_uring: requests in flight per thread
+bool sweep_depth = false;		//io_uring: sweep the queue depth from 1 to queue_depth
+ADVICE advice = ADV_NONE;		//mmap: madvise hint on both mappings
+bool populate = false;		//mmap: MAP_POPULATE, fault the whole file in before the timed run
 int thread_num = 1;
+bool thread_set = false;		//thread num given by the user
+SWEEP sweep_mode = SWEEP_NONE;		//thread-scaling sweep, default = single run
 long data_size = DEFAULTDATASIZE;
 long block_size = EBBLOCK;
 int repeat_num = 1;
+PLACEMENT placement = PIN_NONE;		//thread placement policy, default = unpinned
+std::string cpu_list;		//explicit CPU list for PIN_LIST
 
 
-std::size_t** rdmIndex;	//generate random variables for each thread, used in random write
-char** bufferStore;		//buffer to store content read from file, each thread possessing one unique buffer
+long run_id = 0;		//counts the timed runs, seeds the random offsets so every repeat draws new ones
+char** bufferStore;		//buffer to store content read from file, each thread possessing one unique page-aligned buffer
 int writeFile;		//file descriptor to be written
 int readFile;		//file descriptor to be read
 
+uring* rings;		//io_uring: one ring per thread
+char*** slotBuf;	//io_uring: queue_depth page-aligned buffers per thread, registered with its ring
+int ringFile[2];	//io_uring: read and write file, registered with every ring
+
+latency_hist* readHist;		//per-I/O latency of every thread, in ns, reset for every repeat
+latency_hist* writeHist;
+std::ofstream histOut;		//--hist-file, closed if not given
+
+int fillFile;		//test file: descriptor the writers fill
+long* fillStart;	//test file: range of every writer, writer i fills [fillStart[i], fillStart[i+1])
+int* fillErr;		//test file: errno of a failed write of every writer, 0 if none
+uint64_t fill_seed;	//test file: seed of the random data, recorded in the sidecar
+
+char* readMap;		//mmap: mapping of the file to be read, set up anew for every repeat
+char* writeMap;		//mmap: mapping of the file to be written
+
 std::size_t* fileRangePerThrd;	//file location range per thread, defines the range from start point each thread can access
 std::size_t* fileStartPerThrd;	//file offset to the beginning for each thread
 std::size_t* numOptPerThrd;		//number of operations per thread
 
+int* pinCpu;		//CPU each thread is pinned to, NULL if unpinned
+int* ranCpu;		//CPU each thread actually ran on, recorded when the thread finishes
+
 
 /*
 function declarations
  */
 void helper (char *arg);
 long getSizeInByte (std::string input);
+long directAlignment (const char *path);
+int openData (const char *name, int flags);
+double runThreadCount (int n);
+double iopsOf (double mbps);
+void printLatencyReport (const latency_hist *hist, const char *kind, int iter);
+void ringsCreate ();
+void ringsDestroy ();
+void printDepthReport (const int *depth, const double *rate, int n);
+bool datasetValid (const char *name, long size);
+void provisionData (const char *name, long size);
+void *fillData (void *argv);
+void mapData ();
+void unmapData ();
 double disk_benchmark ();
 void *readWrite (void *argv);
 void *sqtialRead (void *argv);
 void *rdmRead (void *argv);
+void *uringIO (void *argv);
+void *mmapReadWrite (void *argv);
+void *mmapSqtialRead (void *argv);
+void *mmapRdmRead (void *argv);
 
 
 
@@ -0,0 +1,128 @@
+/**
+ * @file latency_hist.cpp
+ * merging, percentiles and dumps of log-linear latency histograms
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <cstring>
+#include <iostream>
+#include "latency_hist.h"
+
+using namespace std;
+
+
+
+/**
+ * lowest value counted in a bucket
+ * @param  b bucket
+ * @return   value
+ */
+static uint64_t bucketLow (int b) {
+	if (b < HIST_SUB)
+		return b;
+	int shift = b / HIST_HALF - 1;
+	return (uint64_t)(b - shift * HIST_HALF) << shift;
+}
+
+
+
+/**
+ * highest value counted in a bucket
+ * @param  b bucket
+ * @return   value
+ */
+static uint64_t bucketHigh (int b) {
+	if (b < HIST_SUB)
+		return b;
+	int shift = b / HIST_HALF - 1;
+	return bucketLow(b) + ((uint64_t)1 << shift) - 1;
+}
+
+
+
+/**
+ * empty a histogram
+ * @param h histogram
+ */
+void histReset (latency_hist *h) {
+	memset(h->count, 0, sizeof(h->count));
+	h->total = 0;
+	h->min = UINT64_MAX;
+	h->max = 0;
+	h->sum = 0;
+}
+
+
+
+/**
+ * add the values of one histogram to another, the per-thread histograms of a run are merged this way
+ * @param dst histogram added to
+ * @param src histogram added
+ */
+void histMerge (latency_hist *dst, const latency_hist *src) {
+	for (int b = 0; b < HIST_BUCKETS; b++)
+		dst->count[b] += src->count[b];
+	dst->total += src->total;
+	dst->sum += src->sum;
+	if (src->min < dst->min)
+		dst->min = src->min;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+
+
+/**
+ * value below which p percent of the values lie
+ * the highest value of the bucket it falls in, like HdrHistogram, bounded by the recorded min and max
+ * @param  h histogram
+ * @param  p percentile, 0 to 100
+ * @return   value, 0 if the histogram is empty
+ */
+uint64_t histPercentile (const latency_hist *h, double p) {
+	if (h->total == 0)
+		return 0;
+	uint64_t rank = (uint64_t)(p / 100 * h->total + 0.5);
+	if (rank < 1)
+		rank = 1;
+	uint64_t seen = 0;
+	for (int b = 0; b < HIST_BUCKETS; b++) {
+		seen += h->count[b];
+		if (seen >= rank) {
+			uint64_t v = bucketHigh(b);
+			return v > h->max ? h->max : v < h->min ? h->min : v;
+		}
+	}
+	return h->max;
+}
+
+
+
+/**
+ * mean of the recorded values
+ * @param  h histogram
+ * @return   mean, 0 if the histogram is empty
+ */
+double histMean (const latency_hist *h) {
+	return h->total ? h->sum / h->total : 0;
+}
+
+
+
+/**
+ * write the non-empty buckets, one per line: lowest value, highest value, count and cumulative fraction
+ * @param h   histogram
+ * @param out stream to write to
+ */
+void histDump (const latency_hist *h, ostream &out) {
+	out<<"#low(ns)\thigh(ns)\tcount\tcumulative"<<endl;
+	uint64_t seen = 0;
+	for (int b = 0; b < HIST_BUCKETS; b++) {
+		if (h->count[b] == 0)
+			continue;
+		seen += h->count[b];
+		out<<bucketLow(b)<<"\t"<<bucketHigh(b)<<"\t"<<h->count[b]<<"\t"<<(double)seen / h->total<<endl;
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef _LATENCY_HIST_H_
+#define _LATENCY_HIST_H_
+
+#include <cstdint>
+#include <ctime>		//clock_gettime
+#include <ostream>
+
+/*
+* log-linear latency histogram in the style of HdrHistogram
+* values below HIST_SUB are counted exactly, above that every power of two is split into HIST_SUB/2 linear buckets,
+* so a bucket is never wider than 1/64 (1.6%) of its values, over the whole range of a 64-bit ns count
+* recording is an index computation and one increment, no allocation and no locking: every thread owns its histogram
+ */
+
+#define HIST_SUBBITS 7
+#define HIST_SUB (1 << HIST_SUBBITS)		//exact values, and twice the buckets per power of two
+#define HIST_HALF (HIST_SUB / 2)
+#define HIST_BUCKETS ((64 - HIST_SUBBITS + 1) * HIST_HALF + HIST_HALF)
+
+
+typedef struct {
+	uint64_t count[HIST_BUCKETS];
+	uint64_t total;		//values recorded
+	uint64_t min;
+	uint64_t max;
+	double sum;		//for the mean
+} latency_hist;
+
+
+/**
+ * time stamp for latency samples, in ns, CLOCK_MONOTONIC_RAW like the worker pool
+ * a vDSO call, about 20ns on current x86
+ */
+static inline uint64_t histNow () {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &t);
+	return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+
+/**
+ * bucket of a value: the value itself below HIST_SUB,
+ * otherwise the top HIST_SUBBITS-1 bits below the leading one, offset by the power of two
+ */
+static inline int histBucket (uint64_t v) {
+	if (v < HIST_SUB)
+		return (int)v;
+	int shift = 63 - __builtin_clzll(v) - (HIST_SUBBITS - 1);
+	return shift * HIST_HALF + (int)(v >> shift);
+}
+
+
+/**
+ * record one value, inline so the timed loops pay no call
+ */
+static inline void histRecord (latency_hist *h, uint64_t v) {
+	h->count[histBucket(v)]++;
+	h->total++;
+	h->sum += v;
+	if (v < h->min)
+		h->min = v;
+	if (v > h->max)
+		h->max = v;
+}
+
+
+/*
+* functions declarations
+ */
+void histReset (latency_hist *h);
+void histMerge (latency_hist *dst, const latency_hist *src);
+uint64_t histPercentile (const latency_hist *h, double p);
+double histMean (const latency_hist *h);
+void histDump (const latency_hist *h, std::ostream &out);
+
+
+#endif
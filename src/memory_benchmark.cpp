@@ -10,12 +10,18 @@
 #include <cstdlib>
 #include <iostream>
 #include <sys/time.h>	
+#include <sched.h>		//sched_getcpu
 #include <unistd.h>		//getopt
+#include <getopt.h>		//getopt_long
 #include <cstring>		//memset and memcpy
+#include <sstream>		//sizeString
 #include <string>
 #include <algorithm>	//std::generate
 #include <random>		//random function
+#include <cstdint>		//uint64_t
+#include <sys/mman.h>		//madvise
 #include <cmath>
+#include <immintrin.h>	//SSE2 loads and stores, streaming stores, AVX2 and AVX-512 loads
 #include "memory_benchmark.h"
 
 using namespace std;
@@ -27,14 +33,34 @@ using namespace std;
  */
 void helper (char *arg) {
 	cout<<arg<<": Memory benchmark tool, Version 0.0.1 (lchen96@hawk.iit.edu)"<<endl<<endl;
-	cout<<"usage:\t"<<arg<<" [-h] [-o <operation>] [-t <threads>] [-s <datasize>] [-b <blocksize] [-r <repeats>]"<<endl;
+	cout<<"usage:\t"<<arg<<" [-h] [-m <metric>] [-o <operation>] [-t <threads>] [-s <datasize>] [-b <blocksize] [-r <repeats>] [-n] [-w <bits>] [-g <pages>] [-p <placement>] [-c <cpulist>] [--sweep-threads[=linear|pow2]] [--numa[=local|<node>]] [--numa-matrix] [--stride=<bytes>] [--elem=<bytes>] [--prefetch=<elements>]"<<endl;
 	cout<<"Arguments:"<<endl;
 	cout<<"\t-h\tlist available commands"<<endl;
-	cout<<"\t-o\toperation type, read&write=0 (defualted), sqtwrite=1,rdmwrite=2"<<endl;
-	cout<<"\t-t\tnumber of threads ( <= "<<MAXTHREADS<<") [default = 1]"<<endl;
-	cout<<"\t-s\tmemory size to be operated, ending with B/KB/MB/GB, default with B [default = 1.25GB]"<<endl;
+	cout<<"\t-m\tmetric, latency=0 (pointer chase over growing working sets), throughput=1 (defaulted),"<<endl
+		<<"\t\tloaded latency=2 (pointer chase on one thread while the other -t threads run -o8 or -o3 at stepped intensity)"<<endl;
+	cout<<"\t-o\toperation type, read&write=0 (defualted), sqtwrite=1,rdmwrite=2,"<<endl
+		<<"\t\tSTREAM copy=3, scale=4, add=5, triad=6 (on three arrays of <datasize> each, block size unused),"<<endl
+		<<"\t\trdmupdate=7 (GUPS, xor of random 8-byte words, block size unused),"<<endl
+		<<"\t\tread=8 (SIMD loads summed into a reduction, block size unused),"<<endl
+		<<"\t\tstrided read=9 (one element every --stride bytes, sweeps the strides without --stride, block size unused)"<<endl;
+	cout<<"\t-t\tnumber of threads ( <= "<<onlineCpus()<<" online CPUs) [default = 1]"<<endl;
+	cout<<"\t-s\tmemory size to be operated, ending with B/KB/MB/GB, default with B [default = 1.25GB]"<<endl
+		<<"\t\tlatency: largest working set [default = "<<LTC_LLC_TIMES<<"x the last-level cache]"<<endl;
 	cout<<"\t-b\tblock size, ending with B/KB/MB [default = 8B]"<<endl;
 	cout<<"\t-r\tnumber of repeated benchmark tests[default = 1]"<<endl;
+	cout<<"\t-w\tread only: load width in bits, 128, 256 or 512 [default = widest the CPU supports]"<<endl;
+	cout<<"\t-g\tpage size of the buffers, 4KB=0, THP=1, 2MB hugetlb=2, 1GB hugetlb=3 [default = system THP policy]"<<endl;
+	cout<<"\t-n\tSTREAM kernels: non-temporal (streaming) stores that bypass the caches [default = regular stores]"<<endl;
+	cout<<"\t-p\tthread placement, compact=0, scatter=1, physical cores only=2, SMT pairs=3 [default = unpinned]"<<endl;
+	cout<<"\t-c\tpin threads to an explicit CPU list, like 0-3,8"<<endl;
+	cout<<"\t--sweep-threads\trun every thread count from 1 to -t (default: all online CPUs) on the same data,"<<endl
+		<<"\t\tlinear or powers of two (defaulted), and report speedup, efficiency and the serial fraction"<<endl;
+	cout<<"\t--numa\tlocal (defaulted): every thread first-touches its own slice, <node>: bind all buffers to that node"<<endl;
+	cout<<"\t--stride\tstrided read: bytes between two elements, at least --elem [default = sweep "<<elem_size<<"B to "<<sizeString(STRIDE_MAXSWEEP)<<" in powers of two,"<<endl
+		<<"\t\tplus 3 cache lines and page-crossing strides]"<<endl;
+	cout<<"\t--elem\tstrided read: bytes read at every position, 4, 8, 16, 32 or 64 [default = 8]"<<endl;
+	cout<<"\t--prefetch\tstrided read: software prefetch (prefetcht0) that many elements ahead [default = off]"<<endl;
+	cout<<"\t--numa-matrix\tbandwidth of -o and pointer-chase latency from the CPUs of every node to the memory of every node"<<endl;
 	cout<<endl;
 
 }
@@ -75,32 +101,49 @@ int main (int argc, char *argv[]) {
 	 */
 	int c;
 	int flag;
-	// only accepts "hfitlr" arguments, where for "tlr" the argument can be optional
-	while ((c = getopt (argc, argv, ":ho::t::s::b::r::")) != -1) 
+	static struct option long_options[] = {
+		{"sweep-threads", optional_argument, NULL, SWEEP_OPT},
+		{"numa", optional_argument, NULL, NUMA_OPT},
+		{"numa-matrix", no_argument, NULL, NUMA_MATRIX_OPT},
+		{"stride", required_argument, NULL, STRIDE_OPT},
+		{"elem", required_argument, NULL, ELEM_OPT},
+		{"prefetch", required_argument, NULL, PREFETCH_OPT},
+		{0, 0, 0, 0}
+	};
+	// only accepts "hfitlrpc" arguments, where for "tlrp" the argument can be optional
+	while ((c = getopt_long (argc, argv, ":hm::o::t::s::b::r::p::c:ng:w:", long_options, NULL)) != -1) 
 		switch (c) {
 			case 'h':
 				helper(argv[0]);
 				exit(0);
 				break;
+			case 'm':
+				metric = stoi(optarg);
+				if (metric != LTC && metric != THRPT && metric != LOADED) {
+					cerr<<"metric can only be 0 to 2!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
 			case 'o':
 				flag = stoi(optarg);
-				if (flag == 0)
-					op_type = RDW;
-				else if (flag == 1)
-					op_type = SW;
-				else if (flag == 2)
-					op_type = RMW;
+				if (flag >= RDW && flag < NUM_OP) {
+					op_type = flag;
+					op_set = true;
+				}
 				else {
-					cerr<<"option type can only be 0,1 or 2!\n"<<endl;
+					cerr<<"option type can only be 0 to "<<NUM_OP - 1<<"!\n"<<endl;
 					helper(argv[0]);
 					exit(1);
 				}
 				break;
 			case 't':
-				if ((thread_num = atoi(optarg)) > MAXTHREADS) {
-					cout<<"Exceed the supported thread limit!"<<endl;
+				thread_num = atoi(optarg);
+				if (thread_num < 1 || thread_num > onlineCpus()) {
+					cout<<"Thread number must be 1 to the online CPU count ("<<onlineCpus()<<")!"<<endl;
 					exit(2);
 				}
+				thread_set = true;
 				break;
 			case 's':
 				if ((data_size = getSizeInByte (optarg)) == -1) {
@@ -108,6 +151,7 @@ int main (int argc, char *argv[]) {
 					helper(argv[0]);
 					exit(1);
 				}
+				size_set = true;
 				break;
 			case 'b':
 				if ((block_size = getSizeInByte(optarg)) == -1) {
@@ -123,8 +167,81 @@ int main (int argc, char *argv[]) {
 			case 'r':
 				repeat_num = stoi(optarg);
 				break;
+			case 'p':
+				placement = stoi(optarg);
+				if (placement < PIN_COMPACT || placement >= PIN_LIST) {
+					cerr<<"placement can only be 0 to "<<PIN_LIST - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'c':
+				placement = PIN_LIST;
+				cpu_list = optarg;
+				break;
+			case 'n':
+				nt_store = true;
+				break;
+			case 'w':
+				read_width = stoi(optarg);
+				if (read_width != 128 && read_width != 256 && read_width != 512) {
+					cerr<<"load width can only be 128, 256 or 512!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case 'g':
+				page_mode = stoi(optarg);
+				if (page_mode < PAGE_4K || page_mode >= NUM_PAGE) {
+					cerr<<"page size can only be 0 to "<<NUM_PAGE - 1<<"!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case SWEEP_OPT:
+				if ((sweep_mode = parseSweepMode(optarg)) == -1) {
+					cerr<<"sweep can only be linear or pow2!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case NUMA_OPT:
+				if ((numa_mode = parseNumaMode(optarg)) == NUMA_INVALID) {
+					cerr<<"numa can only be local or a node id!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case NUMA_MATRIX_OPT:
+				numa_matrix = true;
+				break;
+			case STRIDE_OPT:
+				if ((stride = getSizeInByte(optarg)) <= 0) {
+					cerr<<"stride must be a positive size!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case ELEM_OPT:
+				elem_size = stoi(optarg);
+				if (elem_size != 4 && elem_size != 8 && elem_size != 16 && elem_size != 32 && elem_size != 64) {
+					cerr<<"element size can only be 4, 8, 16, 32 or 64!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
+			case PREFETCH_OPT:
+				prefetch_dist = stol(optarg);
+				if (prefetch_dist < 0) {
+					cerr<<"prefetch distance cannot be negative!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
 			case ':':	/*missing option argument, using default value*/
-				if (optopt == 'o')
+				if (optopt == 'm')
+					metric = THRPT;
+				else if (optopt == 'o')
 					op_type = RDW;
 				else if (optopt == 't')
 					thread_num = 1;
@@ -134,6 +251,8 @@ int main (int argc, char *argv[]) {
 					block_size = EBBLOCK;
 				else if (optopt == 'i')
 					repeat_num = 1;
+				else if (optopt == 'p')
+					placement = PIN_COMPACT;
 				break;
 			case '?':	/* invalid option*/
 			default:
@@ -144,13 +263,93 @@ int main (int argc, char *argv[]) {
 
 
 
+		if (read_width == 0)
+			read_width = widthSupported(512) ? 512 : widthSupported(256) ? 256 : 128;
+		else if (!widthSupported(read_width)) {
+			cerr<<read_width<<"-bit loads are not supported by this CPU!\n"<<endl;
+			exit(1);
+		}
+
+		if (nt_store && !IS_STREAM(op_type)) {
+			cerr<<"non-temporal stores are only available for the STREAM kernels (-o3 to -o6)!\n"<<endl;
+			exit(1);
+		}
+
+		if (op_type != STRIDED && (stride != 0 || prefetch_dist != 0 || elem_size != 8)) {
+			cerr<<"--stride, --elem and --prefetch only apply to the strided read (-o9)!\n"<<endl;
+			exit(1);
+		}
+		if (op_type == STRIDED && stride != 0 && stride < elem_size) {
+			cerr<<"the stride must be at least the element size ("<<elem_size<<"B)!\n"<<endl;
+			exit(1);
+		}
+		if (op_type == STRIDED && stride == 0 && (sweep_mode != SWEEP_NONE || numa_matrix)) {
+			cerr<<"the strided read sweeps the strides itself, give one --stride for --sweep-threads or --numa-matrix!\n"<<endl;
+			exit(1);
+		}
+
+		if (metric == LTC && (thread_num > 1 || sweep_mode != SWEEP_NONE)) {
+			cerr<<"latency mode runs a single thread!\n"<<endl;
+			exit(1);
+		}
+
+		if (numa_matrix && (metric != THRPT || sweep_mode != SWEEP_NONE || placement != PIN_NONE || numa_mode != NUMA_DEFAULT)) {
+			cerr<<"--numa-matrix places threads and memory itself, it runs alone!\n"<<endl;
+			exit(1);
+		}
+		if (metric == LOADED) {
+			if (!op_set)
+				op_type = READ;
+			if (op_type != READ && op_type != COPY) {
+				cerr<<"loaded latency generates its load with read (-o8) or copy (-o3) only!\n"<<endl;
+				exit(1);
+			}
+			if (nt_store || sweep_mode != SWEEP_NONE) {
+				cerr<<"loaded latency steps the load itself, no -n or --sweep-threads!\n"<<endl;
+				exit(1);
+			}
+		}
+		if (numa_mode == NUMA_LOCAL && metric != THRPT) {
+			cerr<<"latency mode runs a single thread, bind its memory with --numa=<node>!\n"<<endl;
+			exit(1);
+		}
+
+		if (numa_matrix) {
+			numaMatrix();
+			return 0;
+		}
+
+		if ((sweep_mode != SWEEP_NONE || metric == LOADED) && !thread_set)
+			thread_num = onlineCpus();
+
+		pinCpu = planPlacement(placement, thread_num, cpu_list);
+		if (placement != PIN_NONE && pinCpu == NULL)
+			exit(1);
+
+		if (metric == LTC) {
+			latencyMode();
+			delete[] pinCpu;
+			return 0;
+		}
+		if (metric == LOADED) {
+			loadedLatency();
+			delete[] pinCpu;
+			return 0;
+		}
+
 		/*
 		print user's input information
 		 */	
 		cout<<"\nThe benchmarking begins with:"
-			<<"\n\tOperation:\t\t"<<op[op_type]
-			<<"\n\t#Thread:\t\t"<<thread_num
+			<<"\n\tOperation:\t\t"<<op[op_type]<<(IS_STREAM(op_type) ? (nt_store ? " (non-temporal stores)" : " (regular stores)") : "")
+			<<(op_type == READ ? " (" + to_string(read_width) + "-bit loads)" : "")
+			<<(op_type == STRIDED ? " (" + to_string(elem_size) + "B elements, stride " + (stride ? sizeString(stride) : "sweep")
+				+ ", prefetch " + (prefetch_dist ? to_string(prefetch_dist) + " elements ahead" : "off") + ")" : "")
+			<<"\n\t#Thread:\t\t"<<(sweep_mode == SWEEP_NONE ? to_string(thread_num) : "sweep 1 to " + to_string(thread_num) + " (" + sweep_name[sweep_mode] + ")")
+			<<"\n\tPlacement:\t\t"<<(placement == PIN_NONE ? "unpinned" : placement_name[placement] + string(" (") + cpuListString(pinCpu, thread_num) + ")")
 			<<"\n\tData size:\t\t"<<BYTE_IN_GB(data_size)<<" GB"
+			<<"\n\tPages:\t\t\t"<<(page_mode == PAGE_SYSTEM ? "system default" : page_name[page_mode])
+			<<"\n\tNUMA:\t\t\t"<<numaString()
 			<<"\n\tBlock size:\t\t";
 		if (block_size < ONEKB)
 				cout<<block_size<<"B\t";
@@ -162,153 +361,681 @@ int main (int argc, char *argv[]) {
 			cout<<BYTE_IN_GB(block_size)<<"GB";
 		cout<<"\n\t#Iteration:\t\t"<<repeat_num<<endl<<endl<<endl;
 
-		//to reducce the memory consumption, allocating space based on benchmark purpose
-		//to accelerate speed, generating random values in advance
-		memRangePerThrd = new size_t[thread_num];
-		memStartPerThrd = new size_t[thread_num];
-		numOptPerThrd = new size_t[thread_num];
-
-		size_t perrange = (size_t) data_size / thread_num;
-		for (int i = 0; i < thread_num-1; i++) {
-			memRangePerThrd[i] = perrange;
-			memStartPerThrd[i] = i * perrange;
-			numOptPerThrd[i] = perrange / block_size;
-		}
-		memRangePerThrd[thread_num-1] = data_size - perrange * (thread_num - 1);
-		memStartPerThrd[thread_num-1] = perrange * (thread_num - 1);
-		numOptPerThrd[thread_num-1] = memRangePerThrd[thread_num-1] / block_size;
-
+		allocBuffers();
+		if (numa_mode != NUMA_LOCAL)		//first touch happens in the workers otherwise
+			initBuffers(0, data_size);
+		ranCpu = new int[thread_num];
+		readSink = new uint64_t[thread_num];
 
-		if (op_type == RDW) {		//allocate memory for reading
-			sourceMem = new char[data_size];
-			memset(sourceMem, '1', data_size);
-		}
-		// } else {				//allocate memory for storing data, which will be directly written
-		// 	dataSample = new char[block_size];
-		// 	memset(dataSample, '2', block_size);
-		// }
-
-		if (op_type == RMW) {		//generate random numbers in advance
-			rdmIndex = new size_t* [thread_num];
-			int sindex = 0;
-			for (int i = 0; i < thread_num; i ++) {
-				// random_device rd;		//obtain a seed for the random number engine
-				// mt19937 gen(rd());		//mersenne_twister_engine seeded
-				// uniform_int_distribution<size_t> dis(0, memRangePerThrd[i] - 1 - block_size);	//uniform distribution
-				
-				rdmIndex[i] = new size_t[numOptPerThrd[i]];
-
-				// for (int j = 0; j < numOptPerThrd[i]; j++) {
-				// 	rdmIndex[i][j] = dis(gen);
-				// }
-				//generate(rdmIndex + sindex, rdmIndex + sindex + numOptPerThrd[i], dis);	//generate random numbers in advance
-				//sindex += numOptPerThrd[i];
+		cout<<"Mem\tOpType\t#Thread\tDataSize\tBlockSize\tThroughput(MB/sec)\tUpdates(GUPS)\tTime(us)\tCPUs"<<endl;
+		if (op_type == STRIDED && stride == 0) {		//bandwidth against stride
+			long *strides;
+			int steps = strideList(&strides);
+			double *rate = new double[steps];
+			for (int s = 0; s < steps; s++) {
+				stride = strides[s];
+				rate[s] = runThreadCount(thread_num);
 			}
+			reportStrides(strides, rate, steps);
+			stride = 0;
+			delete[] rate;
+			delete[] strides;
+		} else if (sweep_mode == SWEEP_NONE)
+			runThreadCount(thread_num);
+		else {
+			int *counts;
+			int steps = sweepThreadCounts(sweep_mode, thread_num, &counts);
+			double *rate = new double[steps];
+			for (int s = 0; s < steps; s++)
+				rate[s] = runThreadCount(counts[s]);
+			printScalingReport(counts, rate, steps, "MB/s");
+			delete[] rate;
+			delete[] counts;
 		}
-		
-		destMem = new char[data_size];
 
 
-		//float *runtime = (float *) malloc (sizeof(float) * repeat_num); 
-		float *runtime = new float[repeat_num];
+		reportBuffers();
+		freeBuffers();
 
-		cout<<"Mem\tOpType\t#Thread\tDataSize\tBlockSize\tThroughput(MB/sec)\tLatency(us)"<<endl;
-		for (int i = 0; i < repeat_num; i++) {
+		delete[] pinCpu;
+		delete[] ranCpu;
+		delete[] readSink;
 
-			if (op_type == RMW) {
-				for (int j = 0; j < thread_num; j++) {
-					random_device rd;		//obtain a seed for the random number engine
-					mt19937 gen(rd());		//mersenne_twister_engine seeded
-					uniform_int_distribution<size_t> dis(0, memRangePerThrd[i] - 1 - block_size);	//uniform distribution
-					for (int k = 0; k < numOptPerThrd[j]; k++) {
-						rdmIndex[i][j] = dis(gen);
-					}
-				}
-			}
+		return 0;
+
+}
 
-			runtime[i] = memory_benchmark();
-			cout<<"#Iter "<<i<<"\t"<<op[op_type]<<"\t"<<thread_num
-				<<"\t"<<BYTE_IN_GB(data_size)<<"GB\t";
 
-			if (block_size < ONEKB)
-				cout<<block_size<<"B\t";
-			else if (block_size < ONEMB)
-				cout<<BYTE_IN_KB(block_size)<<"KB\t";
-			else if (block_size < ONEGB)
-				cout<<BYTE_IN_MB(block_size)<<"MB\t";
-			else
-				cout<<BYTE_IN_GB(block_size)<<"GB\t";
 
-			cout<<BYTE_IN_MB(data_size)/runtime[i]<<"MB/s\t"
-				<<runtime[i]*1e6<<"us"<<endl;
+/**
+ * map a benchmark buffer with the page size of page_mode and bind it to numa_mode if that is a node,
+ * exits if the pages are not available
+ * @param  bytes buffer size
+ * @return       buffer, free it with pageFree
+ */
+char *allocBuffer (long bytes) {
+	char *mem = pageAlloc(bytes, page_mode);
+	if (mem == NULL) {
+		cerr<<"Cannot allocate "<<sizeString(bytes)<<" with "<<(page_mode == PAGE_SYSTEM ? "default" : page_name[page_mode])<<" pages!"<<endl;
+		exit(1);
+	}
+	if (numa_mode >= 0 && !bindToNode(mem, bytes, numa_mode))
+		exit(1);
+	return mem;
+}
+
+
+
+/**
+ * map the buffers of the current operation, bound to numa_mode if it is a node
+ * sourceMem: read&write, STREAM and the read-only kinds, destMem: all but read only, thirdMem: STREAM
+ */
+void allocBuffers () {
+	sourceMem = (op_type == RDW || IS_STREAM(op_type) || IS_READONLY(op_type)) ? allocBuffer(data_size) : NULL;
+	destMem = !IS_READONLY(op_type) ? allocBuffer(data_size) : NULL;
+	thirdMem = IS_STREAM(op_type) ? allocBuffer(data_size) : NULL;
+}
+
+
+
+/**
+ * write the initial content of a byte range of every buffer, so page faults stay out of the timed runs
+ * the thread that calls it first decides the node of the pages (first touch)
+ * @param start first byte of the range
+ * @param bytes length of the range
+ */
+void initBuffers (size_t start, size_t bytes) {
+	if (op_type == RDW || IS_READONLY(op_type))
+		memset(sourceMem + start, '1', bytes);
+	if (IS_READONLY(op_type))
+		return;
+	if (IS_STREAM(op_type)) {		//STREAM arrays a, b, c of doubles
+		size_t first = start / sizeof(double), last = (start + bytes) / sizeof(double);
+		fill((double *)sourceMem + first, (double *)sourceMem + last, 1.0);
+		fill((double *)destMem + first, (double *)destMem + last, 2.0);
+		fill((double *)thirdMem + first, (double *)thirdMem + last, 0.0);
+	} else if (op_type == GUPS) {		//table[i] = i as in HPCC
+		uint64_t *table = (uint64_t *)destMem;
+		for (size_t i = start / sizeof(uint64_t); i < (start + bytes) / sizeof(uint64_t); i++)
+			table[i] = i;
+	} else
+		memset(destMem + start, 0, bytes);
+}
+
+
 
-				
+/**
+ * give back the pages of every buffer, the next touch faults them in again (on the node of the toucher)
+ */
+void dropBuffers () {
+	char *buffers[] = {sourceMem, destMem, thirdMem};
+	for (int i = 0; i < 3; i++)
+		if (buffers[i] != NULL)
+			madvise(buffers[i], data_size, MADV_DONTNEED);
+}
+
+
+
+/**
+ * print the page size and the nodes each buffer actually got, they are all touched by now
+ */
+void reportBuffers () {
+	const char *names[] = {"source", "dest", "third"};
+	char *buffers[] = {sourceMem, destMem, thirdMem};
+	cout<<endl<<"Pages obtained ("<<(page_mode == PAGE_SYSTEM ? "system default" : page_name[page_mode])<<" requested):"<<endl;
+	for (int i = 0; i < 3; i++)
+		if (buffers[i] != NULL)
+			cout<<"\t"<<names[i]<<"\t"<<pageReport(buffers[i])<<", "<<nodeReport(buffers[i], data_size)<<endl;
+}
+
+
+
+/**
+ * unmap the buffers of allocBuffers
+ */
+void freeBuffers () {
+	char *buffers[] = {sourceMem, destMem, thirdMem};
+	for (int i = 0; i < 3; i++)
+		pageFree(buffers[i], data_size, page_mode);
+	sourceMem = destMem = thirdMem = NULL;
+}
+
+
+
+/**
+ * whether the CPU has the instructions of a load width
+ * @param  bits 128 (SSE2, always there on x86-64), 256 (AVX2) or 512 (AVX-512F)
+ * @return      true if supported
+ */
+bool widthSupported (int bits) {
+	if (bits == 512)
+		return __builtin_cpu_supports("avx512f");
+	if (bits == 256)
+		return __builtin_cpu_supports("avx2");
+	return true;
+}
+
+
+
+/**
+ * NUMA policy of the buffers
+ * @return description for the banner
+ */
+string numaString () {
+	if (numa_mode == NUMA_DEFAULT)
+		return "default (main thread touches all memory)";
+	if (numa_mode == NUMA_LOCAL)
+		return "local (each thread first-touches its slice)";
+	return "bound to node " + to_string(numa_mode) + " (distances " + nodeDistance(numa_mode) + ")";
+}
+
+
+
+/**
+ * human readable size, like 48KB
+ * @param  bytes size in Byte
+ * @return       size with the largest unit that keeps it at least 1
+ */
+string sizeString (long bytes) {
+	ostringstream out;
+	if (bytes < ONEKB)
+		out<<bytes<<"B";
+	else if (bytes < ONEMB)
+		out<<BYTE_IN_KB(bytes)<<"KB";
+	else if (bytes < ONEGB)
+		out<<BYTE_IN_MB(bytes)<<"MB";
+	else
+		out<<BYTE_IN_GB(bytes)<<"GB";
+	return out.str();
+}
+
+
+
+/**
+ * latency mode: ns per dependent load over working sets from LTC_MINSIZE to several times the last-level cache
+ * every working set is a random cyclic permutation of its cache lines, so each load depends on the previous one
+ * and neither the prefetchers nor the out-of-order core can overlap them
+ * lines are spread over the whole set, so large sets also pay TLB misses, as a random access would
+ */
+void latencyMode () {
+	cache_level *caches;
+	int levels = readCaches(&caches);
+	long maxsize = chaseSize(caches, levels);
+
+	cout<<"\nThe benchmarking begins with:"
+		<<"\n\tMetric:\t\t\tLatency (dependent loads, random cyclic permutation of "<<CACHELINE<<"B lines)"
+		<<"\n\t#Thread:\t\t1"
+		<<"\n\tPlacement:\t\t"<<(placement == PIN_NONE ? "unpinned" : placement_name[placement] + string(" (") + cpuListString(pinCpu, 1) + ")")
+		<<"\n\tWorking set:\t\t"<<sizeString(LTC_MINSIZE)<<" to "<<sizeString(maxsize)<<", "<<LTC_STEPS<<" steps per doubling"
+		<<"\n\tCaches (sysfs):\t\t";
+	for (int i = 0; i < levels; i++)
+		cout<<"L"<<caches[i].level<<" "<<sizeString(caches[i].size)<<(i < levels - 1 ? ", " : "");
+	if (levels == 0)
+		cout<<"unknown";
+	cout<<"\n\tPages:\t\t\t"<<(page_mode == PAGE_SYSTEM ? "system default" : page_name[page_mode]);
+	cout<<"\n\tNUMA:\t\t\t"<<numaString();
+	cout<<"\n\t#Iteration:\t\t"<<repeat_num<<endl<<endl<<endl;
+
+	char *mem = allocBuffer(maxsize);
+	ranCpu = new int[1];
+	poolCreate(1, pinCpu);
+
+	//working sets grow by 2^(1/LTC_STEPS), rounded to whole cache lines
+	int steps = (int)ceil(log2((double)maxsize / LTC_MINSIZE) * LTC_STEPS) + 1;
+	long *sizes = new long[steps];
+	double *latency = new double[steps];
+	int n = 0;
+	for (int k = 0; k < steps; k++) {
+		long size = (long)(LTC_MINSIZE * pow(2.0, (double)k / LTC_STEPS));
+		size = min(size - size % CACHELINE, maxsize);
+		if (n > 0 && size <= sizes[n - 1])
+			continue;
+		sizes[n++] = size;
+	}
+
+	cout<<"Mem\tOpType\tWorkingSet\t#Loads\tLatency(ns)\tCPUs"<<endl;
+	for (int k = 0; k < n; k++)
+		latency[k] = chaseLatency(mem, sizes[k]);
+
+	reportCacheLevels(sizes, latency, n);
+	cout<<endl<<"Pages obtained:\t"<<pageReport(mem)<<", "<<nodeReport(mem, maxsize)<<endl;
+
+	poolDestroy();
+	pageFree(mem, maxsize, page_mode);
+	delete[] sizes;
+	delete[] latency;
+	delete[] caches;
+	delete[] ranCpu;
+}
+
+
+
+/**
+ * largest working set of the latency sweep: -s if given, else LTC_LLC_TIMES x the last-level cache
+ * @param  caches cache levels of readCaches
+ * @param  levels number of cache levels
+ * @return        bytes, whole cache lines
+ */
+long chaseSize (const cache_level *caches, int levels) {
+	long size = size_set ? data_size : (levels > 0 ? caches[levels - 1].size * LTC_LLC_TIMES : LTC_NOLLC);
+	return max(size - size % CACHELINE, LTC_MINSIZE);
+}
+
+
+
+/**
+ * latency of one working set on the current single-worker pool, one result line per repeat
+ * the chain is walked once untimed to warm the caches and the TLB
+ * @param  mem  memory of at least size bytes
+ * @param  size working set
+ * @return      best ns per dependent load of the repeats
+ */
+double chaseLatency (char *mem, long size) {
+	size_t lines = size / CACHELINE;
+	buildChain(mem, lines);
+	chaseLoads = lines - lines % 8 + 8;
+	poolRun(pointerChase);
+
+	chaseLoads = max(LTC_MINLOADS, (long)lines * 2);
+	chaseLoads -= chaseLoads % 8;		//the chase is unrolled by 8
+	double best = 0;
+	for (int i = 0; i < repeat_num; i++) {
+		poolRun(pointerChase);
+		const thread_time *times = poolThreadTimes();
+		double ns = (times[0].end - times[0].start) * 1e9 / chaseLoads;
+		if (i == 0 || ns < best)
+			best = ns;
+		cout<<"#Iter "<<i<<"\tPointer chase\t"<<sizeString(size)<<"\t"<<chaseLoads<<"\t"<<ns<<"\t"<<cpuListString(ranCpu, 1)<<endl;
+	}
+	return best;
+}
+
+
+
+/**
+ * NUMA matrix: bandwidth of the -o operation and pointer-chase latency from the CPUs of every node
+ * to the memory of every node, memory bound with mbind
+ * bandwidth uses all CPUs of the node (at most -t if given), latency one thread on its first CPU
+ */
+void numaMatrix () {
+	int *cpuNodes, *memNodes;
+	int ncpu = readNodes("has_cpu", &cpuNodes);
+	int nmem = readNodes("has_memory", &memNodes);
+	cache_level *caches;
+	int levels = readCaches(&caches);
+	long chase = chaseSize(caches, levels);
+
+	cout<<"\nThe benchmarking begins with:"
+		<<"\n\tMetric:\t\t\tNUMA matrix, "<<op[op_type]<<" bandwidth and pointer-chase latency over "<<sizeString(chase)
+		<<"\n\tCPU nodes:\t\t"<<cpuListString(cpuNodes, ncpu)
+		<<"\n\tMemory nodes:\t\t"<<cpuListString(memNodes, nmem)
+		<<"\n\t#Thread:\t\t"<<(thread_set ? "up to " + to_string(thread_num) : string("all CPUs of the node"))
+		<<"\n\tData size:\t\t"<<BYTE_IN_GB(data_size)<<" GB"
+		<<"\n\tPages:\t\t\t"<<(page_mode == PAGE_SYSTEM ? "system default" : page_name[page_mode])
+		<<"\n\t#Iteration:\t\t"<<repeat_num<<endl<<endl<<endl;
+
+	double *bandwidth = new double[ncpu * nmem];
+	double *latency = new double[ncpu * nmem];
+	ranCpu = new int[onlineCpus()];
+	readSink = new uint64_t[onlineCpus()];
+	for (int m = 0; m < nmem; m++) {
+		numa_mode = memNodes[m];
+		allocBuffers();
+		initBuffers(0, data_size);
+		char *mem = allocBuffer(chase);
+		for (int c = 0; c < ncpu; c++) {
+			int n = nodeCpus(cpuNodes[c], &pinCpu);
+			if (thread_set)
+				n = min(n, thread_num);
+			cout<<"#CPU node "<<cpuNodes[c]<<" -> memory node "<<memNodes[m]<<endl;
+			cout<<"Mem\tOpType\t#Thread\tDataSize\tBlockSize\tThroughput(MB/sec)\tUpdates(GUPS)\tTime(us)\tCPUs"<<endl;
+			bandwidth[c * nmem + m] = runThreadCount(n);
+
+			cout<<"Mem\tOpType\tWorkingSet\t#Loads\tLatency(ns)\tCPUs"<<endl;
+			poolCreate(1, pinCpu);
+			latency[c * nmem + m] = chaseLatency(mem, chase);
+			poolDestroy();
+			delete[] pinCpu;
+			cout<<endl;
 		}
+		pageFree(mem, chase, page_mode);
+		freeBuffers();
+	}
 
+	cout<<endl<<op[op_type]<<" bandwidth (MB/s), rows: CPU node, columns: memory node"<<endl<<"CPU\\Mem";
+	for (int m = 0; m < nmem; m++)
+		cout<<"\tnode"<<memNodes[m];
+	cout<<endl;
+	for (int c = 0; c < ncpu; c++) {
+		cout<<"node"<<cpuNodes[c];
+		for (int m = 0; m < nmem; m++)
+			cout<<"\t"<<bandwidth[c * nmem + m];
+		cout<<endl;
+	}
+	cout<<endl<<"Latency (ns per dependent load), rows: CPU node, columns: memory node"<<endl<<"CPU\\Mem";
+	for (int m = 0; m < nmem; m++)
+		cout<<"\tnode"<<memNodes[m];
+	cout<<endl;
+	for (int c = 0; c < ncpu; c++) {
+		cout<<"node"<<cpuNodes[c];
+		for (int m = 0; m < nmem; m++)
+			cout<<"\t"<<latency[c * nmem + m];
+		cout<<"\t(SLIT distances "<<nodeDistance(cpuNodes[c])<<")"<<endl;
+	}
 
-		
-		/*
-		free space before exiting application
-		 */
-		delete[] runtime;
-		if (op_type == RMW) {
-			for (int i = 0; i < thread_num; i++)
-				delete[] rdmIndex[i];
-			delete[] rdmIndex;
+	delete[] bandwidth;
+	delete[] latency;
+	delete[] cpuNodes;
+	delete[] memNodes;
+	delete[] caches;
+	delete[] ranCpu;
+	delete[] readSink;
+}
+
+
+
+/**
+ * loaded latency: ns per dependent load of one chasing thread while the other threads generate load,
+ * each load thread pauses load_delay spin iterations after every cache line, from idle to full speed
+ * as in Intel MLC's loaded-latency test, the result is a curve of latency against bandwidth
+ * thread 0 chases over LTC_LLC_TIMES x the last-level cache, threads 1 to -t - 1 stream their slice of -s
+ */
+void loadedLatency () {
+	cache_level *caches;
+	int levels = readCaches(&caches);
+	long chase = levels > 0 ? caches[levels - 1].size * LTC_LLC_TIMES : LTC_NOLLC;		//-s sizes the load here
+	chase -= chase % CACHELINE;
+	int loaders = thread_num - 1;
+
+	cout<<"\nThe benchmarking begins with:"
+		<<"\n\tMetric:\t\t\tLoaded latency, pointer chase over "<<sizeString(chase)<<" on thread 0"
+		<<"\n\tLoad:\t\t\t"<<op[op_type]<<" on "<<loaders<<" thread(s), stepped by spinning after every "<<CACHELINE<<"B line"
+		<<"\n\t#Thread:\t\t"<<thread_num
+		<<"\n\tPlacement:\t\t"<<(placement == PIN_NONE ? "unpinned" : placement_name[placement] + string(" (") + cpuListString(pinCpu, thread_num) + ")")
+		<<"\n\tData size:\t\t"<<BYTE_IN_GB(data_size)<<" GB"
+		<<"\n\tPages:\t\t\t"<<(page_mode == PAGE_SYSTEM ? "system default" : page_name[page_mode])
+		<<"\n\tNUMA:\t\t\t"<<numaString()
+		<<"\n\t#Iteration:\t\t"<<repeat_num<<endl<<endl;
+	if (loaders == 0)
+		cout<<"no load threads with -t1, only the idle latency is measured"<<endl;
+	cout<<endl;
+
+	allocBuffers();
+	initBuffers(0, data_size);
+	char *mem = allocBuffer(chase);
+	buildChain(mem, chase / CACHELINE);
+
+	//thread 0 only chases, the load threads split the data
+	memRangePerThrd = new size_t[thread_num];
+	memStartPerThrd = new size_t[thread_num];
+	memRangePerThrd[0] = memStartPerThrd[0] = 0;
+	for (int i = 1; i < thread_num; i++) {
+		size_t perrange = (size_t)data_size / loaders;
+		perrange -= perrange % CACHELINE;
+		memStartPerThrd[i] = (i - 1) * perrange;
+		memRangePerThrd[i] = i < thread_num - 1 ? perrange : data_size - memStartPerThrd[i];
+	}
+	ranCpu = new int[thread_num];
+	readSink = new uint64_t[thread_num];
+	loadMB = new double[thread_num];
+	loadSeconds = new double[thread_num];
+	poolCreate(thread_num, pinCpu);
+
+	int points = loaders > 0 ? NUM_DELAY : 1;
+	double *bandwidth = new double[points];
+	double *latency = new double[points];
+	cout<<"OpType\tDelay\tBandwidth(MB/sec)\tLatency(ns)\tCPUs"<<endl;
+	for (int k = 0; k < points; k++) {
+		load_delay = loaded_delay[k];
+		bandwidth[k] = latency[k] = 0;
+		for (int i = 0; i < repeat_num; i++) {
+			loadStop.store(false);
+			poolRun(loadedThread);
+			double mbs = 0;
+			for (int j = 1; j < thread_num; j++)
+				if (loadSeconds[j] > 0)
+					mbs += loadMB[j] / loadSeconds[j];
+			double ns = chaseSeconds * 1e9 / LOADED_LOADS;
+			bandwidth[k] += mbs / repeat_num;
+			latency[k] += ns / repeat_num;
+			cout<<"#Iter "<<i<<"\t"<<op[op_type]<<"\t"<<(load_delay == LOADED_IDLE ? string("idle") : to_string(load_delay))
+				<<"\t"<<mbs<<"MB/s\t"<<ns<<"\t"<<cpuListString(ranCpu, thread_num)<<endl;
 		}
-//		delete[] dataSample;
-		if (op_type == RDW)
-			delete[] sourceMem;
+	}
 
-		delete[] destMem;
+	cout<<endl<<"Loaded latency curve (mean of the repeats), delay in spin iterations per "<<CACHELINE<<"B line:"<<endl;
+	cout<<"Delay\tBandwidth(MB/s)\tLatency(ns)\tvs idle"<<endl;
+	for (int k = 0; k < points; k++)
+		cout<<(loaded_delay[k] == LOADED_IDLE ? string("idle") : to_string(loaded_delay[k]))<<"\t"<<bandwidth[k]<<"\t"
+			<<latency[k]<<"\t"<<latency[k] / latency[0]<<"x"<<endl;
+	reportBuffers();
+	cout<<"\tchase\t"<<pageReport(mem)<<", "<<nodeReport(mem, chase)<<endl;
 
-		delete[] memRangePerThrd;
-		delete[] memStartPerThrd;
-		delete[] numOptPerThrd;
+	poolDestroy();
+	pageFree(mem, chase, page_mode);
+	freeBuffers();
+	delete[] bandwidth;
+	delete[] latency;
+	delete[] memRangePerThrd;
+	delete[] memStartPerThrd;
+	delete[] ranCpu;
+	delete[] readSink;
+	delete[] loadMB;
+	delete[] loadSeconds;
+	delete[] caches;
+}
 
-		return 0;
 
+
+/**
+ * link the first lines cache lines of mem into one cycle in random order
+ * a Fisher-Yates shuffle of the line order, each line then points to the next one and the last back to the first
+ * @param mem   memory, at least lines * CACHELINE bytes
+ * @param lines number of cache lines
+ */
+void buildChain (char *mem, size_t lines) {
+	size_t *order = new size_t[lines];
+	for (size_t i = 0; i < lines; i++)
+		order[i] = i;
+	mt19937_64 gen(lines);		//fixed seed, the same working set always gets the same chain
+	for (size_t i = lines - 1; i > 0; i--) {
+		uniform_int_distribution<size_t> dis(0, i);
+		swap(order[i], order[dis(gen)]);
+	}
+	for (size_t i = 0; i < lines; i++)
+		*(void **)(mem + order[i] * CACHELINE) = mem + order[(i + 1) % lines] * CACHELINE;
+	chaseStart = (void **)(mem + order[0] * CACHELINE);
+	delete[] order;
 }
 
 
+
 /**
- * memory benchmark function implenemtation
- * @return benchmarking time in seconds
+ * find the cache levels on the latency curve
+ * the curve is smoothed with a median of three neighbours first, so a single noisy step is no level
+ * a level ends at the last working set before the latency rises LTC_JUMP above its plateau,
+ * the next plateau starts where the curve flattens again (two steps in a row add less than LTC_FLAT each)
+ * @param sizes   working set of each step, increasing
+ * @param latency best ns per load of each step
+ * @param n       number of steps
  */
-double memory_benchmark () {
-	struct timeval starttime, endtime;
-	long runtime;
-	pthread_t *threads = new pthread_t [thread_num];
-	int* thrdID = new int[thread_num];
-	for (int i = 0; i < thread_num; i++)
-		thrdID[i] = i; 
-
-	gettimeofday(&starttime, NULL);
-	if (op_type == RDW) {
-		for (int tid = 0; tid < thread_num; tid++)
-			//pthread_create(&threads[tid], NULL, readWrite, (void *)&tid);
-			pthread_create(&threads[tid], NULL, readWrite, (void *)(thrdID + tid));
-	} else if (op_type == SW) {
-		for (int tid = 0; tid < thread_num; tid++)
-			pthread_create(&threads[tid], NULL, sqtialWrite, (void *)(thrdID + tid));
-	} else if (op_type == RMW) {
-		for (int tid = 0; tid < thread_num; tid++)
-			pthread_create(&threads[tid], NULL, rdmWrite, (void *)(thrdID + tid));
-	} else {
-		cerr<<"Invalid structions! opType can only be 0,1,2!"<<endl;
-		abort();
+void reportCacheLevels (const long *sizes, const double *latency, int n) {
+	double *smooth = new double[n];
+	for (int k = 0; k < n; k++) {
+		if (k == 0 || k == n - 1) {
+			smooth[k] = latency[k];
+			continue;
+		}
+		double v[3] = {latency[k - 1], latency[k], latency[k + 1]};
+		sort(v, v + 3);
+		smooth[k] = v[1];
+	}
+
+	cout<<endl<<"Detected levels (latency plateaus):"<<endl;
+	int level = 1;
+	double plateau = smooth[0];
+	bool settled = true;
+	for (int k = 1; k < n; k++) {
+		if (settled && smooth[k] > plateau * LTC_JUMP) {
+			cout<<"\tLevel "<<level++<<"\tup to "<<sizeString(sizes[k - 1])<<"\t"<<plateau<<" ns"<<endl;
+			settled = false;
+		} else if (!settled && k + 1 < n && smooth[k] < smooth[k - 1] * LTC_FLAT && smooth[k + 1] < smooth[k] * LTC_FLAT) {
+			plateau = smooth[k];
+			settled = true;
+		}
+	}
+	if (settled)
+		cout<<"\tLevel "<<level<<"\tbeyond\t"<<plateau<<" ns (last plateau, memory if the sweep exceeds the last-level cache)"<<endl;
+	else
+		cout<<"\tLevel "<<level<<"\tbeyond\t"<<smooth[n - 1]<<" ns (still rising at the largest working set)"<<endl;
+	delete[] smooth;
+}
+
+
+
+/**
+ * split the data among n threads and run the benchmark repeat_num times on a pool of n workers
+ * the workers are pinned to the first n CPUs of the placement
+ * @param  n thread count
+ * @return   best throughput of the repeats, in MB/s
+ */
+double runThreadCount (int n) {
+	thread_num = n;
+
+	//to reducce the memory consumption, allocating space based on benchmark purpose
+	//random addresses are generated inline by each thread, no index memory
+	memRangePerThrd = new size_t[thread_num];
+	memStartPerThrd = new size_t[thread_num];
+	numOptPerThrd = new size_t[thread_num];
+
+	size_t perrange = (size_t) data_size / thread_num;
+	perrange -= perrange % CACHELINE;
+	for (int i = 0; i < thread_num-1; i++) {
+		memRangePerThrd[i] = perrange;
+		memStartPerThrd[i] = i * perrange;
+		numOptPerThrd[i] = perrange / block_size;
+	}
+	memRangePerThrd[thread_num-1] = data_size - perrange * (thread_num - 1);
+	memStartPerThrd[thread_num-1] = perrange * (thread_num - 1);
+	numOptPerThrd[thread_num-1] = memRangePerThrd[thread_num-1] / block_size;
+	if (IS_STREAM(op_type))		//STREAM kernels work on doubles, not on blocks
+		for (int i = 0; i < thread_num; i++)
+			numOptPerThrd[i] = memRangePerThrd[i] / sizeof(double);
+	else if (op_type == GUPS)		//updates of 8-byte words
+		for (int i = 0; i < thread_num; i++)
+			numOptPerThrd[i] = memRangePerThrd[i] / sizeof(uint64_t) * GUPS_PASSES;
+	else if (op_type == READ)		//bytes, the whole slice
+		for (int i = 0; i < thread_num; i++)
+			numOptPerThrd[i] = memRangePerThrd[i];
+	else if (op_type == STRIDED)		//elements that fit in the slice
+		for (int i = 0; i < thread_num; i++)
+			numOptPerThrd[i] = memRangePerThrd[i] < (size_t)elem_size ? 0 : (memRangePerThrd[i] - elem_size) / stride + 1;
+
+
+	//float *runtime = (float *) malloc (sizeof(float) * repeat_num); 
+	float *runtime = new float[repeat_num];
+	double best = 0;
+	poolCreate(thread_num, pinCpu);
+	if (numa_mode == NUMA_LOCAL) {		//every worker faults in its own slice, again for every thread count
+		dropBuffers();
+		poolRun(firstTouch);
 	}
+	double *thrdMB = new double[thread_num];		//data moved by each thread, for the per-thread report
+	size_t updates = 0;		//random accesses of one run, every block write or word update counts once
 	for (int i = 0; i < thread_num; i++) {
-		pthread_join(threads[i], NULL);
+		if (IS_STREAM(op_type))
+			thrdMB[i] = BYTE_IN_MB(numOptPerThrd[i] * sizeof(double) * op_traffic[op_type]);
+		else if (op_type == GUPS)
+			thrdMB[i] = BYTE_IN_MB(numOptPerThrd[i] * sizeof(uint64_t) * 2);
+		else if (op_type == READ)
+			thrdMB[i] = BYTE_IN_MB(numOptPerThrd[i]);
+		else if (op_type == STRIDED)
+			thrdMB[i] = BYTE_IN_MB(numOptPerThrd[i] * elem_size);
+		else
+			thrdMB[i] = BYTE_IN_MB(numOptPerThrd[i] * block_size);
+		updates += numOptPerThrd[i];
+	}
+	double totalMB = BYTE_IN_MB(data_size * op_traffic[op_type]);		//every array read or written once
+	if (op_type == RMW)		//only whole blocks are written
+		totalMB = BYTE_IN_MB(updates * block_size);
+	else if (op_type == STRIDED)		//useful bytes, the elements read, not the lines around them
+		totalMB = BYTE_IN_MB(updates * elem_size);
+
+	for (int i = 0; i < repeat_num; i++) {
+		runtime[i] = memory_benchmark();
+		if (totalMB / runtime[i] > best)
+			best = totalMB / runtime[i];
+		cout<<"#Iter "<<i<<"\t"<<op[op_type]<<(IS_STREAM(op_type) && nt_store ? "(NT)" : "")
+			<<(op_type == READ ? "(" + to_string(read_width) + "b)" : "")
+			<<(op_type == STRIDED ? "(" + to_string(elem_size) + "B" + (prefetch_dist ? ",pf" + to_string(prefetch_dist) : "") + ")" : "")
+			<<"\t"<<thread_num<<"\t"<<BYTE_IN_GB(data_size)<<"GB\t";
+
+		if (op_type == STRIDED)		//the stride takes the place of the block size
+			cout<<sizeString(stride)<<"\t";
+		else if (IS_STREAM(op_type) || op_type == GUPS || op_type == READ)
+			cout<<"-\t";
+		else if (block_size < ONEKB)
+			cout<<block_size<<"B\t";
+		else if (block_size < ONEMB)
+			cout<<BYTE_IN_KB(block_size)<<"KB\t";
+		else if (block_size < ONEGB)
+			cout<<BYTE_IN_MB(block_size)<<"MB\t";
+		else
+			cout<<BYTE_IN_GB(block_size)<<"GB\t";
+
+		cout<<totalMB/runtime[i]<<"MB/s\t";
+		if (IS_RANDOM(op_type))
+			cout<<updates / runtime[i] / 1e9<<"GUPS\t";
+		else
+			cout<<"-\t";
+		cout<<runtime[i]*1e6<<"us\t"<<cpuListString(ranCpu, thread_num)<<endl;
+		printThreadReport(thrdMB, "MB/s", ranCpu);
+
+			
 	}
-	gettimeofday(&endtime, NULL);
 
-	delete[] threads;
-	delete[] thrdID;
-	
-	runtime = (endtime.tv_sec - starttime.tv_sec) * 1000000L + (endtime.tv_usec - starttime.tv_usec);	//time in microsecond
-	return runtime/1000000.0;	//time in seconds 
 
+	poolDestroy();
+	delete[] thrdMB;
+	delete[] runtime;
+	delete[] memRangePerThrd;
+	delete[] memStartPerThrd;
+	delete[] numOptPerThrd;
+
+	return best;
+}
+
+
+/**
+ * memory benchmark function implenemtation
+ * @return benchmarking time in seconds
+ */
+double memory_benchmark () {
+	run_id++;
+	//workers already exist, only barrier release to last finish is timed
+	if (op_type == RDW)
+		return poolRun(readWrite);
+	else if (op_type == SW)
+		return poolRun(sqtialWrite);
+	else if (op_type == RMW)
+		return poolRun(rdmWrite);
+	else if (op_type == GUPS)
+		return poolRun(rdmUpdate);
+	else if (op_type == COPY)
+		return poolRun(streamCopy);
+	else if (op_type == SCALE)
+		return poolRun(streamScale);
+	else if (op_type == ADD)
+		return poolRun(streamAdd);
+	else if (op_type == TRIAD)
+		return poolRun(streamTriad);
+	else if (op_type == READ)
+		return poolRun(readOnly);
+	else if (op_type == STRIDED)
+		return poolRun(stridedRead);
+
+	cerr<<"Invalid structions! opType can only be 0 to "<<NUM_OP - 1<<"!"<<endl;
+	abort();
 }
 
 
@@ -324,6 +1051,7 @@ void *readWrite (void *argv) {
 	for (size_t i = 0; i < numOptPerThrd[crtThrdID]; i++) {
 		memcpy(destMem + memStartPerThrd[crtThrdID] + i*block_size, sourceMem + memStartPerThrd[crtThrdID] + i*block_size, block_size);
 	}
+	ranCpu[crtThrdID] = sched_getcpu();
 	//pthread_exit(NULL);
 	return NULL;
 }
@@ -339,28 +1067,482 @@ void *sqtialWrite (void *argv) {
 	for (size_t i = 0; i < numOptPerThrd[crtThrdID]; i++) {
 		memset(destMem + memStartPerThrd[crtThrdID] + i*block_size, '1', block_size);
 	}
+	ranCpu[crtThrdID] = sched_getcpu();
 	//pthread_exit(NULL);
 	return NULL;
 }
 
 
+/*
+* random addresses are drawn inline with xorshift64*, one generator per thread
+* the state comes from splitmix64 of (run, thread), so every repeat and thread gets its own stream
+* a draw x maps to [0, n) as the high half of x * n, which needs no division
+ */
+static inline uint64_t splitmix64 (uint64_t x) {
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+static inline uint64_t xorshift64s (uint64_t &state) {
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 0x2545F4914F6CDD1DULL;
+}
+
+static inline uint64_t rangeDraw (uint64_t x, uint64_t n) {
+	return (uint64_t)(((unsigned __int128)x * n) >> 64);
+}
+
+
 /**
- * random write thread implementation
+ * random write thread implementation, whole blocks at random offsets of the thread's range
  * @param  argv thread ID
  * @return      exit current thread once it completes without being suspended
  */
 void *rdmWrite (void *argv) {
 //	int crtThrdID = pthread_self();
 	int crtThrdID = *(int *) argv;
+	uint64_t state = splitmix64(run_id * thread_num + crtThrdID) | 1;		//xorshift state must not be 0
+	char *base = destMem + memStartPerThrd[crtThrdID];
+	uint64_t offsets = memRangePerThrd[crtThrdID] - block_size + 1;		//block starts that stay in the range
 	for (size_t i = 0; i < numOptPerThrd[crtThrdID]; i++) {
-		memset(destMem + memStartPerThrd[crtThrdID] + rdmIndex[crtThrdID][i], '1', block_size);
+		memset(base + rangeDraw(xorshift64s(state), offsets), '1', block_size);
 	}
+	ranCpu[crtThrdID] = sched_getcpu();
 	//pthread_exit(NULL);
 	return NULL;
 }
 
 
+/**
+ * random update thread implementation, table[r] ^= r for random 8-byte words of the thread's range
+ * updates are independent, so the core keeps many misses in flight as in HPCC RandomAccess
+ * @param  argv thread ID
+ * @return      NULL
+ */
+void *rdmUpdate (void *argv) {
+	int crtThrdID = *(int *) argv;
+	uint64_t state = splitmix64(run_id * thread_num + crtThrdID) | 1;
+	uint64_t *table = (uint64_t *)(destMem + memStartPerThrd[crtThrdID]);
+	uint64_t words = memRangePerThrd[crtThrdID] / sizeof(uint64_t);
+	for (size_t i = 0; i < numOptPerThrd[crtThrdID]; i++) {
+		uint64_t r = xorshift64s(state);
+		table[rangeDraw(r, words)] ^= r;
+	}
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+
+/*
+* STREAM kernels on one thread's range, written with SSE2 loads and stores so that the
+* regular variant is never turned into a memcpy call (glibc switches to streaming stores itself for large copies)
+* NT: non-temporal stores, fenced at the end so they are globally visible when the thread finishes
+* ranges start on a cache line and hold a whole number of doubles, an odd last element is done in scalar
+ */
+template <bool NT>
+static inline void storePd (double *p, __m128d v) {
+	if (NT)
+		_mm_stream_pd(p, v);
+	else
+		_mm_store_pd(p, v);
+}
+
+template <bool NT>
+static void copyRange (double *b, const double *a, size_t n) {
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+		storePd<NT>(b + i, _mm_load_pd(a + i));
+	for (; i < n; i++)
+		b[i] = a[i];
+	if (NT)
+		_mm_sfence();
+}
+
+template <bool NT>
+static void scaleRange (double *b, const double *a, size_t n) {
+	__m128d q = _mm_set1_pd(STREAM_SCALAR);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+		storePd<NT>(b + i, _mm_mul_pd(q, _mm_load_pd(a + i)));
+	for (; i < n; i++)
+		b[i] = STREAM_SCALAR * a[i];
+	if (NT)
+		_mm_sfence();
+}
+
+template <bool NT>
+static void addRange (double *c, const double *a, const double *b, size_t n) {
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+		storePd<NT>(c + i, _mm_add_pd(_mm_load_pd(a + i), _mm_load_pd(b + i)));
+	for (; i < n; i++)
+		c[i] = a[i] + b[i];
+	if (NT)
+		_mm_sfence();
+}
+
+template <bool NT>
+static void triadRange (double *c, const double *a, const double *b, size_t n) {
+	__m128d q = _mm_set1_pd(STREAM_SCALAR);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+		storePd<NT>(c + i, _mm_add_pd(_mm_load_pd(a + i), _mm_mul_pd(q, _mm_load_pd(b + i))));
+	for (; i < n; i++)
+		c[i] = a[i] + STREAM_SCALAR * b[i];
+	if (NT)
+		_mm_sfence();
+}
 
 
+/**
+ * STREAM copy thread implementation, b = a
+ * @param  argv thread ID
+ * @return      NULL
+ */
+void *streamCopy (void *argv) {
+	int crtThrdID = *(int *) argv;
+	const double *a = (const double *)(sourceMem + memStartPerThrd[crtThrdID]);
+	double *b = (double *)(destMem + memStartPerThrd[crtThrdID]);
+	if (nt_store)
+		copyRange<true>(b, a, numOptPerThrd[crtThrdID]);
+	else
+		copyRange<false>(b, a, numOptPerThrd[crtThrdID]);
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
 
 
+/**
+ * STREAM scale thread implementation, b = q * a
+ * @param  argv thread ID
+ * @return      NULL
+ */
+void *streamScale (void *argv) {
+	int crtThrdID = *(int *) argv;
+	const double *a = (const double *)(sourceMem + memStartPerThrd[crtThrdID]);
+	double *b = (double *)(destMem + memStartPerThrd[crtThrdID]);
+	if (nt_store)
+		scaleRange<true>(b, a, numOptPerThrd[crtThrdID]);
+	else
+		scaleRange<false>(b, a, numOptPerThrd[crtThrdID]);
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+/**
+ * STREAM add thread implementation, c = a + b
+ * @param  argv thread ID
+ * @return      NULL
+ */
+void *streamAdd (void *argv) {
+	int crtThrdID = *(int *) argv;
+	const double *a = (const double *)(sourceMem + memStartPerThrd[crtThrdID]);
+	const double *b = (const double *)(destMem + memStartPerThrd[crtThrdID]);
+	double *c = (double *)(thirdMem + memStartPerThrd[crtThrdID]);
+	if (nt_store)
+		addRange<true>(c, a, b, numOptPerThrd[crtThrdID]);
+	else
+		addRange<false>(c, a, b, numOptPerThrd[crtThrdID]);
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+/**
+ * STREAM triad thread implementation, c = a + q * b
+ * @param  argv thread ID
+ * @return      NULL
+ */
+void *streamTriad (void *argv) {
+	int crtThrdID = *(int *) argv;
+	const double *a = (const double *)(sourceMem + memStartPerThrd[crtThrdID]);
+	const double *b = (const double *)(destMem + memStartPerThrd[crtThrdID]);
+	double *c = (double *)(thirdMem + memStartPerThrd[crtThrdID]);
+	if (nt_store)
+		triadRange<true>(c, a, b, numOptPerThrd[crtThrdID]);
+	else
+		triadRange<false>(c, a, b, numOptPerThrd[crtThrdID]);
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+/**
+ * pointer chase thread implementation, follows chaseLoads links of the chain
+ * @param  argv thread ID
+ * @return      NULL
+ */
+void *pointerChase (void *argv) {
+	int crtThrdID = *(int *) argv;
+	void **p = chaseStart;
+	for (long i = 0; i < chaseLoads; i += 8) {
+		p = (void **)*p;
+		p = (void **)*p;
+		p = (void **)*p;
+		p = (void **)*p;
+		p = (void **)*p;
+		p = (void **)*p;
+		p = (void **)*p;
+		p = (void **)*p;
+	}
+	chaseEnd = p;
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+/**
+ * first-touch thread implementation, writes the initial content of the thread's slice of every buffer
+ * @param  argv thread ID
+ * @return      NULL
+ */
+void *firstTouch (void *argv) {
+	int crtThrdID = *(int *) argv;
+	initBuffers(memStartPerThrd[crtThrdID], memRangePerThrd[crtThrdID]);
+	return NULL;
+}
+
+
+
+/**
+ * loaded latency thread implementation
+ * thread 0 chases LOADED_LOADS / 8 links untimed while the load ramps up, then LOADED_LOADS timed, and stops the load
+ * the others read (or copy) their slice line by line in a loop, spinning load_delay iterations after each line
+ * @param  argv thread ID
+ * @return      NULL
+ */
+void *loadedThread (void *argv) {
+	int crtThrdID = *(int *) argv;
+	struct timespec t0, t1;
+	if (crtThrdID == 0) {
+		chaseLoads = LOADED_LOADS / 8;
+		pointerChase(argv);
+		chaseStart = (void **)chaseEnd;		//carry on where the untimed part stopped
+		chaseLoads = LOADED_LOADS;
+		clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+		pointerChase(argv);
+		clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+		chaseSeconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		loadStop.store(true, memory_order_relaxed);
+		return NULL;
+	}
+
+	loadMB[crtThrdID] = loadSeconds[crtThrdID] = 0;
+	if (load_delay == LOADED_IDLE) {
+		ranCpu[crtThrdID] = sched_getcpu();
+		return NULL;
+	}
+	const uint64_t *src = (const uint64_t *)(sourceMem + memStartPerThrd[crtThrdID]);
+	uint64_t *dst = (uint64_t *)(destMem + memStartPerThrd[crtThrdID]);
+	const size_t step = CACHELINE / sizeof(uint64_t);
+	//whole lines only: the last thread's slice need not end on one, and a partial line would run past it
+	size_t words = memRangePerThrd[crtThrdID] / CACHELINE * step;
+	if (words == 0) {
+		ranCpu[crtThrdID] = sched_getcpu();
+		return NULL;
+	}
+	uint64_t sum = 0;
+	long lines = 0;
+	size_t i = 0;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+	while (!loadStop.load(memory_order_relaxed)) {
+		if (op_type == COPY)
+			for (size_t w = 0; w < step; w++)
+				dst[i + w] = src[i + w];
+		else
+			for (size_t w = 0; w < step; w++)
+				sum += src[i + w];
+		i = i + step < words ? i + step : 0;		//words is a multiple of step, so the next line fits
+		lines++;
+		for (long d = 0; d < load_delay; d++)
+			__asm__ __volatile__("");		//one cycle or so per iteration, not optimised away
+	}
+	clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+	loadSeconds[crtThrdID] = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	loadMB[crtThrdID] = BYTE_IN_MB(lines * CACHELINE * op_traffic[op_type]);
+	readSink[crtThrdID] = sum;
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+/*
+* read-only kernels, four independent accumulators so the adds never limit the loads
+* built with target attributes, the width is chosen at runtime with widthSupported
+* slices start on a cache line, only the tail after the last full unrolled step is read in scalar
+ */
+static uint64_t readTail (const char *p, size_t bytes) {
+	uint64_t sum = 0;
+	for (size_t i = 0; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t))
+		sum += *(const uint64_t *)(p + i);
+	return sum;
+}
+
+static uint64_t read128 (const char *p, size_t bytes) {
+	__m128i s0 = _mm_setzero_si128(), s1 = s0, s2 = s0, s3 = s0;
+	size_t i = 0;
+	for (; i + 64 <= bytes; i += 64) {
+		s0 = _mm_add_epi64(s0, _mm_load_si128((const __m128i *)(p + i)));
+		s1 = _mm_add_epi64(s1, _mm_load_si128((const __m128i *)(p + i + 16)));
+		s2 = _mm_add_epi64(s2, _mm_load_si128((const __m128i *)(p + i + 32)));
+		s3 = _mm_add_epi64(s3, _mm_load_si128((const __m128i *)(p + i + 48)));
+	}
+	__m128i s = _mm_add_epi64(_mm_add_epi64(s0, s1), _mm_add_epi64(s2, s3));
+	uint64_t lane[2];
+	_mm_storeu_si128((__m128i *)lane, s);
+	return lane[0] + lane[1] + readTail(p + i, bytes - i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t read256 (const char *p, size_t bytes) {
+	__m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;
+	size_t i = 0;
+	for (; i + 128 <= bytes; i += 128) {
+		s0 = _mm256_add_epi64(s0, _mm256_load_si256((const __m256i *)(p + i)));
+		s1 = _mm256_add_epi64(s1, _mm256_load_si256((const __m256i *)(p + i + 32)));
+		s2 = _mm256_add_epi64(s2, _mm256_load_si256((const __m256i *)(p + i + 64)));
+		s3 = _mm256_add_epi64(s3, _mm256_load_si256((const __m256i *)(p + i + 96)));
+	}
+	__m256i s = _mm256_add_epi64(_mm256_add_epi64(s0, s1), _mm256_add_epi64(s2, s3));
+	uint64_t lane[4];
+	_mm256_storeu_si256((__m256i *)lane, s);
+	return lane[0] + lane[1] + lane[2] + lane[3] + readTail(p + i, bytes - i);
+}
+
+__attribute__((target("avx512f")))
+static uint64_t read512 (const char *p, size_t bytes) {
+	__m512i s0 = _mm512_setzero_si512(), s1 = s0, s2 = s0, s3 = s0;
+	size_t i = 0;
+	for (; i + 256 <= bytes; i += 256) {
+		s0 = _mm512_add_epi64(s0, _mm512_load_si512((const void *)(p + i)));
+		s1 = _mm512_add_epi64(s1, _mm512_load_si512((const void *)(p + i + 64)));
+		s2 = _mm512_add_epi64(s2, _mm512_load_si512((const void *)(p + i + 128)));
+		s3 = _mm512_add_epi64(s3, _mm512_load_si512((const void *)(p + i + 192)));
+	}
+	__m512i s = _mm512_add_epi64(_mm512_add_epi64(s0, s1), _mm512_add_epi64(s2, s3));
+	return (uint64_t)_mm512_reduce_add_epi64(s) + readTail(p + i, bytes - i);
+}
+
+
+/**
+ * read-only thread implementation, sums the thread's slice of sourceMem with read_width-bit loads
+ * @param  argv thread ID
+ * @return      NULL
+ */
+void *readOnly (void *argv) {
+	int crtThrdID = *(int *) argv;
+	const char *p = sourceMem + memStartPerThrd[crtThrdID];
+	size_t bytes = memRangePerThrd[crtThrdID];
+	if (read_width == 512)
+		readSink[crtThrdID] = read512(p, bytes);
+	else if (read_width == 256)
+		readSink[crtThrdID] = read256(p, bytes);
+	else
+		readSink[crtThrdID] = read128(p, bytes);
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
+
+
+
+/**
+ * strides of the bandwidth-against-stride sweep: powers of two from the element size to STRIDE_MAXSWEEP,
+ * plus 3 cache lines (not a power of two, the next-line prefetchers miss it) and two page-crossing strides
+ * off the power-of-two grid, one page plus one line and one and a half pages
+ * @param  strides output array, allocated with new[], ascending
+ * @return         number of strides
+ */
+int strideList (long **strides) {
+	long extra[] = {3 * CACHELINE, STRIDE_PAGE + CACHELINE, STRIDE_PAGE * 3 / 2};
+	int num_extra = sizeof(extra) / sizeof(extra[0]);
+	*strides = new long[64 + num_extra];
+	int n = 0;
+	for (long s = elem_size; s <= STRIDE_MAXSWEEP; s *= 2)
+		(*strides)[n++] = s;
+	for (int i = 0; i < num_extra; i++)
+		if (extra[i] >= elem_size)
+			(*strides)[n++] = extra[i];
+	sort(*strides, *strides + n);
+	return n;
+}
+
+
+
+/**
+ * bandwidth against stride of the sweep
+ * useful bandwidth counts the elements read, line bandwidth the cache lines they sit on:
+ * below a line every byte of the line is eventually read, from a line on every element costs whole lines
+ * @param strides stride of each step
+ * @param rate    best useful bandwidth of each step, MB/s
+ * @param n       number of steps
+ */
+void reportStrides (const long *strides, const double *rate, int n) {
+	cout<<endl<<"Bandwidth against stride ("<<elem_size<<"B elements, prefetch "
+		<<(prefetch_dist ? to_string(prefetch_dist) + " elements ahead" : "off")<<", "<<thread_num<<" thread(s)):"<<endl;
+	cout<<"Stride\tUseful(MB/s)\tLines(MB/s)\tns/elem per thread"<<endl;
+	for (int i = 0; i < n; i++) {
+		long lineBytes = strides[i] < CACHELINE ? strides[i] : CACHELINE * ((elem_size + CACHELINE - 1) / CACHELINE);
+		double ns = thread_num * elem_size / (rate[i] * ONEMB) * 1e9;
+		cout<<sizeString(strides[i])<<"\t"<<rate[i]<<"\t"<<rate[i] * lineBytes / elem_size<<"\t"<<ns<<endl;
+	}
+}
+
+
+
+/*
+* strided read kernel, one element of ELEM bytes every stride bytes, summed so the loads stay live
+* the addresses do not depend on the loads, so the core overlaps the misses as far as its fill buffers allow
+* PREFETCH issues prefetcht0 for the element ahead elements further, a prefetch never faults,
+* so the last ones may point past the slice
+ */
+template <int ELEM, bool PREFETCH>
+static uint64_t strideRange (const char *p, size_t n, size_t stride, size_t ahead) {
+	uint64_t sum = 0;
+	for (size_t i = 0; i < n; i++, p += stride) {
+		if (PREFETCH)
+			_mm_prefetch(p + ahead, _MM_HINT_T0);
+		if (ELEM == 4)
+			sum += *(const uint32_t *)p;
+		else
+			for (int w = 0; w < ELEM / 8; w++)
+				sum += ((const uint64_t *)p)[w];
+	}
+	return sum;
+}
+
+template <int ELEM>
+static uint64_t strideRange (const char *p, size_t n, size_t stride) {
+	if (prefetch_dist == 0)
+		return strideRange<ELEM, false>(p, n, stride, 0);
+	return strideRange<ELEM, true>(p, n, stride, prefetch_dist * stride);
+}
+
+
+/**
+ * strided read thread implementation, reads numOptPerThrd elements of the thread's slice of sourceMem
+ * @param  argv thread ID
+ * @return      NULL
+ */
+void *stridedRead (void *argv) {
+	int crtThrdID = *(int *) argv;
+	const char *p = sourceMem + memStartPerThrd[crtThrdID];
+	size_t n = numOptPerThrd[crtThrdID];
+	if (elem_size == 4)
+		readSink[crtThrdID] = strideRange<4>(p, n, stride);
+	else if (elem_size == 8)
+		readSink[crtThrdID] = strideRange<8>(p, n, stride);
+	else if (elem_size == 16)
+		readSink[crtThrdID] = strideRange<16>(p, n, stride);
+	else if (elem_size == 32)
+		readSink[crtThrdID] = strideRange<32>(p, n, stride);
+	else
+		readSink[crtThrdID] = strideRange<64>(p, n, stride);
+	ranCpu[crtThrdID] = sched_getcpu();
+	return NULL;
+}
@@ -1,16 +1,36 @@
 #ifndef _MEMORY_H_
 #define _MEMORY_H_
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <string>
+#include "affinity.h"
+#include "worker_pool.h"
+#include "scaling.h"
+#include "page_alloc.h"
+#include "numa_node.h"
 
 
 #define RDW	0	//read and write
 #define SW 1	//sequential write
 #define RMW 2	//random write
+#define COPY 3	//STREAM copy:  b = a
+#define SCALE 4	//STREAM scale: b = q * a
+#define ADD 5	//STREAM add:   c = a + b
+#define TRIAD 6	//STREAM triad: c = a + q * b
+#define GUPS 7	//random read-modify-write of 8-byte words (HPCC RandomAccess)
+#define READ 8	//read only, SIMD loads into a live reduction
+#define STRIDED 9	//read only, one element every <stride> bytes, optional software prefetch
+#define NUM_OP 10
+
+#define IS_STREAM(op) ((op) >= COPY && (op) <= TRIAD)
+#define IS_RANDOM(op) ((op) == RMW || (op) == GUPS)
+#define IS_READONLY(op) ((op) == READ || (op) == STRIDED)
 
 #define LTC 0	//latency metric
 #define THRPT 1	//throughput metric
+#define LOADED 2	//loaded latency metric, pointer chase under bandwidth load
 
 #define EBBLOCK	8L			//8b
 #define EKBBLOCK	8192L		//8kb
@@ -30,38 +50,92 @@
 #define BYTE_IN_GB(B) ((double)B/ONEGB)	//Bytes in GB
 
 #define DEFAULTDATASIZE MB_IN_BYTE(1280L)		//1280MB
+#define CACHELINE 64L		//thread ranges start on a cache line, so streaming stores stay aligned
+#define STREAM_SCALAR 3.0	//q of the STREAM scale and triad kernels
+#define GUPS_PASSES 4		//random updates per word of the table, as in HPCC RandomAccess
+
+#define LTC_MINSIZE KB_IN_BYTE(4L)	//latency sweep: smallest working set
+#define LTC_LLC_TIMES 4		//latency sweep: largest working set in multiples of the last-level cache
+#define LTC_NOLLC MB_IN_BYTE(256L)	//latency sweep: largest working set if sysfs has no cache sizes
+#define LTC_STEPS 4			//latency sweep: working sets per doubling
+#define LTC_MINLOADS (1L << 22)	//dependent loads per working set, at least 2 passes over the chain
+#define LTC_JUMP 1.5		//a level ends where the latency exceeds its plateau by 50%, TLB misses alone stay below
+#define LTC_FLAT 1.1		//a new plateau starts where two steps in a row add less than 10% each
+
+#define LOADED_IDLE -1		//loaded latency: load threads stay idle, the unloaded point of the curve
+#define LOADED_LOADS (1L << 20)	//loaded latency: timed dependent loads per point, after 1/8 of that untimed
+
+#define STRIDE_OPT 259		//getopt_long value of --stride, next to NUMA_MATRIX_OPT
+#define PREFETCH_OPT 260	//getopt_long value of --prefetch
+#define ELEM_OPT 261		//getopt_long value of --elem
+#define STRIDE_PAGE KB_IN_BYTE(4L)	//strided read: page of the sweep, strides from here on cross a page per element
+#define STRIDE_MAXSWEEP KB_IN_BYTE(16L)	//strided read: largest power-of-two stride of the sweep
 
 typedef int OP_TYPE;		//operation type
 typedef int METRIC;		//metric
 
 
 
-const int MAXTHREADS = 20;
 const long MINDATASIZE = GB_IN_BYTE(1L);
 const long MAXBLOCKSIZE = MB_IN_BYTE(100L);
 
-const char* op[] = {"Sequential Read&Write", "Sequantial Write", "Random Write"};
+const char* op[] = {"Sequential Read&Write", "Sequantial Write", "Random Write", "Copy", "Scale", "Add", "Triad", "Random Update", "Read", "Strided Read"};
+//bytes counted per byte of one array, STREAM convention: every array read or written once, no write-allocate
+//random update: GUPS_PASSES reads and writes of every word, strided read: counted per element instead
+const int op_traffic[] = {1, 1, 1, 2, 2, 3, 3, GUPS_PASSES * 2, 1, 1};
+//loaded latency: spin iterations after every cache line of load, from no load to full load
+const long loaded_delay[] = {LOADED_IDLE, 50000, 20000, 10000, 5000, 2000, 1000, 500, 200, 100, 50, 20, 0};
+const int NUM_DELAY = sizeof(loaded_delay) / sizeof(loaded_delay[0]);
 
 /* 
 global variables
 */
 OP_TYPE op_type = RDW;
+bool op_set = false;		//operation given by the user
 METRIC metric = THRPT;
 int thread_num = 1;
+bool thread_set = false;		//thread num given by the user
+SWEEP sweep_mode = SWEEP_NONE;		//thread-scaling sweep, default = single run
 long data_size = DEFAULTDATASIZE;
 long block_size = EBBLOCK;
 int repeat_num = 1;
-
-
-std::size_t** rdmIndex;	//generate random variables for each thread, used in random write
+bool size_set = false;		//data size given by the user, latency mode: largest working set
+PAGE_MODE page_mode = PAGE_SYSTEM;	//page size of the buffers, default = system THP policy
+NUMA_MODE numa_mode = NUMA_DEFAULT;	//NUMA placement of the buffers, default = main thread touches all
+bool numa_matrix = false;		//node x node bandwidth and latency matrix
+int read_width = 0;		//read only: load width in bits, 128, 256 or 512, default = widest the CPU has
+long elem_size = 8;		//strided read: bytes read at every position, 4 to 64
+long stride = 0;		//strided read: bytes between two elements, 0 = sweep the strides
+long prefetch_dist = 0;		//strided read: software prefetch that many elements ahead, 0 = off
+bool nt_store = false;		//STREAM kernels: non-temporal (streaming) stores, default = regular stores
+PLACEMENT placement = PIN_NONE;		//thread placement policy, default = unpinned
+std::string cpu_list;		//explicit CPU list for PIN_LIST
+
+
+uint64_t* readSink;		//reduction of each thread's read, keeps the loads alive
+long run_id = 0;		//counts the timed runs, seeds the random streams so every repeat draws new addresses
 //char* dataSample;	//sample data, for write benchmark purpose
 char* sourceMem;	//source memory, used in read+write
 char* destMem;		//destination memory, for write benchmark purpose
+char* thirdMem;		//third array of the STREAM add and triad kernels
 
 std::size_t* memRangePerThrd;	//memory range per thread, defines the range from start point each thread can access
 std::size_t* memStartPerThrd;	//memory offset to the beginning for each thread
 std::size_t* numOptPerThrd;		//number of operations per thread
 
+int* pinCpu;		//CPU each thread is pinned to, NULL if unpinned
+int* ranCpu;		//CPU each thread actually ran on, recorded when the thread finishes
+
+void** chaseStart;		//latency mode: first cache line of the pointer chain
+long chaseLoads;		//latency mode: dependent loads of one run
+void* chaseEnd;		//latency mode: line the chase ended on, keeps the loads alive
+
+long load_delay;		//loaded latency: spin iterations after every cache line of the load threads
+std::atomic<bool> loadStop;		//loaded latency: set by the chase thread when its timed loads are done
+double* loadMB;		//loaded latency: data each load thread moved in the last run
+double* loadSeconds;		//loaded latency: time each load thread ran in the last run
+double chaseSeconds;		//loaded latency: time of the timed loads of the chase thread
+
 
 /*
 functions declarations
@@ -69,10 +143,39 @@ functions declarations
 void helper (char *arg);
 long getSizeInByte (std::string input);
 
+char *allocBuffer (long bytes);
+void allocBuffers ();
+void initBuffers (size_t start, size_t bytes);
+void dropBuffers ();
+void reportBuffers ();
+void freeBuffers ();
+std::string numaString ();
+bool widthSupported (int bits);
+std::string sizeString (long bytes);
+double runThreadCount (int n);
+int strideList (long **strides);
+void reportStrides (const long *strides, const double *rate, int n);
+void latencyMode ();
+long chaseSize (const cache_level *caches, int levels);
+double chaseLatency (char *mem, long size);
+void numaMatrix ();
+void loadedLatency ();
+void buildChain (char *mem, size_t lines);
+void reportCacheLevels (const long *sizes, const double *latency, int n);
+void *pointerChase (void *argv);
+void *loadedThread (void *argv);
+void *firstTouch (void *argv);
+void *stridedRead (void *argv);
 double memory_benchmark ();
 void *readWrite (void *argv);
 void *sqtialWrite (void *argv);
 void *rdmWrite (void *argv);
+void *rdmUpdate (void *argv);
+void *readOnly (void *argv);
+void *streamCopy (void *argv);
+void *streamScale (void *argv);
+void *streamAdd (void *argv);
+void *streamTriad (void *argv);
 
 
 #endif
\ No newline at end of file
@@ -15,6 +15,7 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <getopt.h>		//getopt_long
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netdb.h>
@@ -36,14 +37,17 @@ using namespace std;
  */
 void helper (char *arg) {
 	cout<<arg<<": Network benchmark tool, Version 0.0.1 (lchen96@hawk.iit.edu)"<<endl<<endl;
-	cout<<"usage:\t"<<arg<<" [-h] [-f <role>] [-p <protocol>] [-a <address>] [-t <threads>] [-r <repeats>]"<<endl;
+	cout<<"usage:\t"<<arg<<" [-h] [-f <role>] [-p <protocol>] [-a <address>] [-t <threads>] [-r <repeats>] [--sweep-threads[=linear|pow2]]"<<endl;
 	cout<<"Arguments:"<<endl;
 	cout<<"\t-h\tlist available commands"<<endl;
 	cout<<"\t-f\trole of the App, server=0, client=1"<<endl;
 	cout<<"\t-p\tprotocol, TCP=0, UDP=1"<<endl;
 	cout<<"\t-a\tserver address (default 127.0.0.1)"<<endl;
-	cout<<"\t-t\tnumber of threads ( <= "<<MAXTHREADS<<") [default = 1]"<<endl;
+	cout<<"\t-t\tnumber of threads ( <= "<<onlineCpus()<<" online CPUs) [default = 1]"<<endl;
 	cout<<"\t-r\tnumber of repeated benchmark tests[default = 1]"<<endl;
+	cout<<"\t--sweep-threads\tTCP client only, run every connection count from 1 to -t (default: all online CPUs),"<<endl
+		<<"\t\tlinear or powers of two (defaulted), and report speedup, efficiency and the serial fraction;"<<endl
+		<<"\t\tthe server must run with at least as many threads"<<endl;
 	cout<<endl;
 
 }
@@ -56,7 +60,11 @@ int main (int argc, char* argv[]) {
 	 */
 	int c;
 	int flag;
-	while ((c = getopt (argc, argv, ":hf::p::a::t::r::")) != -1) 
+	static struct option long_options[] = {
+		{"sweep-threads", optional_argument, NULL, SWEEP_OPT},
+		{0, 0, 0, 0}
+	};
+	while ((c = getopt_long (argc, argv, ":hf::p::a::t::r::", long_options, NULL)) != -1) 
 		switch (c) {
 			case 'h':
 				helper(argv[0]);
@@ -90,14 +98,23 @@ int main (int argc, char* argv[]) {
 				strcpy(serverIP, optarg);
 				break;
 			case 't':
-				if ((thread_num = atoi(optarg)) > MAXTHREADS) {
-					cout<<"Exceed the supported thread limit! ( <= "<<MAXTHREADS<<")"<<endl;
+				thread_num = atoi(optarg);
+				if (thread_num < 1 || thread_num > onlineCpus()) {
+					cout<<"Thread number must be 1 to the online CPU count ("<<onlineCpus()<<")!"<<endl;
 					exit(2);
 				}
+				thread_set = true;
 				break;
 			case 'r':
 				repeat_num = stoi(optarg);
 				break;
+			case SWEEP_OPT:
+				if ((sweep_mode = parseSweepMode(optarg)) == -1) {
+					cerr<<"sweep can only be linear or pow2!\n"<<endl;
+					helper(argv[0]);
+					exit(1);
+				}
+				break;
 			case ':':
 				if (optopt == 'p')
 					op_type = TCP;
@@ -115,12 +132,23 @@ int main (int argc, char* argv[]) {
 				abort();
 		}
 
+		//the server counts UDP datagrams per thread and a server thread serves one port,
+		//so only a TCP client can change its connection count between runs
+		if (sweep_mode != SWEEP_NONE) {
+			if (role != CLT || op_type != TCP) {
+				cerr<<"--sweep-threads only applies to the TCP client!"<<endl;
+				exit(1);
+			}
+			if (!thread_set)
+				thread_num = onlineCpus();
+		}
+
 		/*
 		output user's input information
 		 */	
 		cout<<"\nThe benchmarking begins with:"
 			<<"\n\tProtcol:\t\t"<<op[op_type]
-			<<"\n\t#Thread:\t\t"<<thread_num
+			<<"\n\t#Thread:\t\t"<<(sweep_mode == SWEEP_NONE ? to_string(thread_num) : "sweep 1 to " + to_string(thread_num) + " (" + sweep_name[sweep_mode] + ")")
 			<<"\n\tData size:\t\t"<<BYTE_IN_GB(data_size)<<" GB"
 			<<"\n\tBuffer size:\t\t"<<BYTE_IN_KB(BUFFERSIZE)<<" KB"
 			<<"\n\t#Iteration:\t\t"<<repeat_num<<endl<<endl<<endl;	
@@ -135,19 +163,61 @@ int main (int argc, char* argv[]) {
 			memset(sendBuffer[i], '1', BUFFERSIZE);
 		}
 
-		float *runtime = new float[repeat_num];
-
 		cout<<"Network\tProctolType\t#Thread\tDataSize\tBufferSize\tThroughput(Mb/sec)\tLatency(us)"<<endl;
+		if (sweep_mode == SWEEP_NONE)
+			runThreadCount(thread_num);
+		else {
+			int *counts;
+			int steps = sweepThreadCounts(sweep_mode, thread_num, &counts);
+			double *rate = new double[steps];
+			for (int s = 0; s < steps; s++)
+				rate[s] = runThreadCount(counts[s]);
+			printScalingReport(counts, rate, steps, "Mb/s");
+			delete[] rate;
+			delete[] counts;
+		}
+
+		for (int i = 0; i < thread_num; i++) {
+			delete[] recBuffer[i];
+			delete[] sendBuffer[i];
+		}
+		delete[] recBuffer;
+		delete[] sendBuffer;
+		return 0;
+}
+
 
 
-		//benchmark result
-		for (int i = 0; i < repeat_num; i++) {
+/**
+ * run the benchmark repeat_num times with n connections, on a pool of n workers
+ * @param  n thread count, the server must listen with at least n threads
+ * @return   best throughput of the repeats, in Mb/s
+ */
+double runThreadCount (int n) {
+	thread_num = n;
+	float *runtime = new float[repeat_num];
+	double best = 0;
+	poolCreate(thread_num, NULL);
+	double *thrdMb = new double[thread_num];		//megabits sent by each thread, for the per-thread report
+	for (int i = 0; i < thread_num; i++)
+		thrdMb[i] = BYTE_IN_MB(data_size / thread_num / BUFFERSIZE * BUFFERSIZE) * 8;
+
+	//benchmark result
+	for (int i = 0; i < repeat_num; i++) {
 		runtime[i] = network_benchmark();
+		if (BYTE_IN_MB(data_size) * 8 / runtime[i] > best)
+			best = BYTE_IN_MB(data_size) * 8 / runtime[i];
 		cout<<"#Iter "<<i<<"\t"<<op[op_type]<<"\t"<<thread_num<<"\t"
 			<<BYTE_IN_GB(data_size)<<"GB\t"<<BYTE_IN_KB(BUFFERSIZE)<<"KB\t"
 			<<(BYTE_IN_MB(data_size)*8 / runtime[i])<<"\t"
 			<<runtime[i]*1e6/data_size*8*1024<<"us"<<endl;
-		}
+		printThreadReport(thrdMb, "Mb/s", NULL);
+	}
+
+	poolDestroy();
+	delete[] thrdMb;
+	delete[] runtime;
+	return best;
 }
 
 
@@ -157,57 +227,21 @@ int main (int argc, char* argv[]) {
  * @return running time in second
  */
 double network_benchmark () {
-	struct timeval starttime, endtime;
-	long runtime;
-	pthread_t *clientthreads = new pthread_t [thread_num];
-	pthread_t *serverthreads = new pthread_t [thread_num];
-
-	int* clientthrdID = new int[thread_num];
-	int* serverthrdID = new int[thread_num];
-	for (int i = 0; i < thread_num; i++) {
-		clientthrdID[i] = i; 
-		serverthrdID[i] = i;
-	}
-
-	gettimeofday(&starttime, NULL);
+	//workers already exist, only barrier release to last finish is timed
 	if (op_type == TCP) {
-		if (role == SVR) 		
-			for (int tid = 0; tid < thread_num; tid++)
-				pthread_create(&serverthreads[tid], NULL, serverTCP, (void *)(serverthrdID + tid));
+		if (role == SVR)
+			return poolRun(serverTCP);
 		else	//this application is used as client
-			for (int tid = 0; tid < thread_num; tid++)
-				pthread_create(&clientthreads[tid], NULL, clientTCP, (void *)(clientthrdID + tid));
-
+			return poolRun(clientTCP);
 	} else if (op_type == UDP) {
 		if (role == SVR)
-			for (int tid = 0; tid < thread_num; tid++)
-				pthread_create(&serverthreads[tid], NULL, serverUDP, (void *)(serverthrdID + tid));
+			return poolRun(serverUDP);
 		else	//this application is used as client
-			for (int tid = 0; tid < thread_num; tid++)
-				pthread_create(&clientthreads[tid], NULL, clientUDP, (void *)(clientthrdID + tid));
-		
-	}  else {
-		cerr<<"Invalid structions! opType can only be 0,1,2!"<<endl;
-		abort();
+			return poolRun(clientUDP);
 	}
-	if (role == SVR)		//this application is used as server	
-		for (int tid = 0; tid < thread_num; tid++) {
-			pthread_join(serverthreads[tid], NULL);
-		}
-	else	//this application is used as client
-		for (int tid = 0; tid < thread_num; tid++) {
-			pthread_join(clientthreads[tid], NULL);
-		}
-	gettimeofday(&endtime, NULL);
-
-	delete[] serverthreads;
-	delete[] clientthreads;
-
-	delete[] serverthrdID;
-	delete[] clientthrdID;
 
-	runtime = (endtime.tv_sec - starttime.tv_sec) * 1000000L + (endtime.tv_usec - starttime.tv_usec);	//time in microsecond
-	return runtime/1000000.0;	//time in seconds 
+	cerr<<"Invalid structions! opType can only be 0,1,2!"<<endl;
+	abort();
 }
 
 
@@ -218,7 +252,6 @@ double network_benchmark () {
  */
 void *serverTCP (void *argv) {
 	int crtThrdID = *(int *)argv;
-	int ret;
 	
 	struct sockaddr_in serverAddr;
 	int tcpsocket;
@@ -265,7 +298,7 @@ void *serverTCP (void *argv) {
 	 	exit(1); 
 	}
 	close(tcpsocket);
-	pthread_exit(&ret);
+	return NULL;
 }
 
 
@@ -277,7 +310,6 @@ void *serverTCP (void *argv) {
  */
 void *serverUDP (void *argv) {
 	int crtThrdID = *(int *)argv;
-	int ret;
 	
 	struct sockaddr_in serverAddr;
 	int udpsocket;
@@ -308,7 +340,7 @@ void *serverUDP (void *argv) {
 	}
 	close(udpsocket);
 
-	pthread_exit(&ret);
+	return NULL;
 }
 
 
@@ -320,7 +352,6 @@ void *serverUDP (void *argv) {
  */
 void *clientTCP (void *argv) {
 	int crtThrdID = *(int *)argv;
-	int ret;
 
 	struct sockaddr_in host_socket;
 	int clientsock;
@@ -355,7 +386,7 @@ void *clientTCP (void *argv) {
 
 	close (clientsock);
 
-	pthread_exit(&ret);
+	return NULL;
 }
 
 
@@ -366,7 +397,6 @@ void *clientTCP (void *argv) {
  */
 void* clientUDP(void *argv) {
 	int crtThrdID = *(int *)argv;
-	int ret;
 
 	struct sockaddr_in host_socket;
 	int clientsock;
@@ -397,6 +427,6 @@ void* clientUDP(void *argv) {
 
 	close(clientsock);
 
-	pthread_exit(&ret);
+	return NULL;
 }
 
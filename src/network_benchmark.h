@@ -4,6 +4,9 @@
 #include <cstddef>
 //#include <cstdio>
 #include <string>
+#include "affinity.h"
+#include "worker_pool.h"
+#include "scaling.h"
 
 #define TCP 0
 #define UDP 1
@@ -41,7 +44,6 @@ typedef int OP_TYPE;		//operation type
 typedef int METRIC;		//metric
 typedef int ROLE;	//role, client or server
 
-const int MAXTHREADS = 20;
 const long MINDATASIZE = GB_IN_BYTE(1L);
 
 const char* op[] =  {"TCP", "UDP"};
@@ -53,6 +55,8 @@ global variables
  */
 
 int thread_num = 1;
+bool thread_set = false;		//thread num given by the user
+SWEEP sweep_mode = SWEEP_NONE;		//thread-scaling sweep, default = single run
 OP_TYPE op_type = TCP;
 int repeat_num = 1;
 
@@ -74,6 +78,7 @@ function declaration
 
 
 void helper (char *arg);
+double runThreadCount (int n);
 double network_benchmark ();
 void *serverTCP (void *argv);
 void *serverUDP (void *argv);
@@ -0,0 +1,161 @@
+/**
+ * @file numa_node.cpp
+ * NUMA nodes from /sys/devices/system/node, memory binding with the raw mbind and move_pages system calls
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cstdlib>		//strtol
+#include <cerrno>
+#include <unistd.h>		//syscall, sysconf
+#include <sys/syscall.h>	//SYS_mbind, SYS_move_pages
+#include <linux/mempolicy.h>	//MPOL_BIND, MPOL_MF_MOVE
+#include "affinity.h"	//parseCpuList
+#include "numa_node.h"
+
+using namespace std;
+
+
+static const char SYSNODE[] = "/sys/devices/system/node";
+
+
+
+/**
+ * parse the argument of --numa
+ * @param  arg "local", a node id, or NULL when the option has no argument
+ * @return     NUMA_LOCAL, the node id, or NUMA_INVALID
+ */
+NUMA_MODE parseNumaMode (const char *arg) {
+	if (arg == NULL || strcmp(arg, "local") == 0)
+		return NUMA_LOCAL;
+	char *end;
+	long node = strtol(arg, &end, 10);
+	if (*arg == '\0' || *end != '\0' || node < 0 || node >= NUMA_MAXNODES)
+		return NUMA_INVALID;
+	return node;
+}
+
+
+
+/**
+ * read a node list of sysfs
+ * @param  list  "online", "has_cpu" or "has_memory"
+ * @param  nodes output array of node ids, allocated with new[]
+ * @return       number of nodes, a single node 0 if sysfs has no NUMA information
+ */
+int readNodes (const char *list, int **nodes) {
+	ifstream in((string(SYSNODE) + "/" + list).c_str());
+	string line;
+	int n;
+	if (!getline(in, line) || (n = parseCpuList(line, nodes)) <= 0) {
+		*nodes = new int[1];
+		(*nodes)[0] = 0;
+		return 1;
+	}
+	return n;
+}
+
+
+
+/**
+ * CPUs of a node
+ * @param  node node id
+ * @param  cpus output array of CPU ids, allocated with new[]
+ * @return      number of CPUs, 0 if the node has none
+ */
+int nodeCpus (int node, int **cpus) {
+	ifstream in((string(SYSNODE) + "/node" + to_string(node) + "/cpulist").c_str());
+	string line;
+	int n;
+	if (!getline(in, line) || (n = parseCpuList(line, cpus)) <= 0) {
+		if (node != 0)
+			return 0;
+		//no sysfs: every CPU is on node 0
+		n = onlineCpus();
+		*cpus = new int[n];
+		for (int i = 0; i < n; i++)
+			(*cpus)[i] = i;
+	}
+	return n;
+}
+
+
+
+/**
+ * SLIT distances from a node to every node, as the firmware reports them (10 = local)
+ * @param  node node id
+ * @return      like "10 21", empty if unknown
+ */
+string nodeDistance (int node) {
+	ifstream in((string(SYSNODE) + "/node" + to_string(node) + "/distance").c_str());
+	string line;
+	getline(in, line);
+	return line;
+}
+
+
+
+/**
+ * bind a buffer to one node, pages already touched are moved there
+ * @param  mem   buffer, page aligned
+ * @param  bytes buffer size
+ * @param  node  node id
+ * @return       true on success
+ */
+bool bindToNode (char *mem, size_t bytes, int node) {
+	unsigned long mask[NUMA_MAXNODES / (8 * sizeof(unsigned long))] = {0};
+	mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+	//the kernel reads maxnode - 1 bits
+	if (syscall(SYS_mbind, mem, bytes, MPOL_BIND, mask, NUMA_MAXNODES + 1, MPOL_MF_MOVE) != 0) {
+		cerr<<"mbind to node "<<node<<" failed: "<<strerror(errno)<<endl;
+		return false;
+	}
+	return true;
+}
+
+
+
+/**
+ * nodes the resident pages of a buffer are on, from up to NUMA_SAMPLES pages spread over it
+ * @param  mem   buffer
+ * @param  bytes buffer size
+ * @return       like "node0 50%, node1 50%"
+ */
+string nodeReport (const char *mem, size_t bytes) {
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t pages = (bytes + page - 1) / page;
+	size_t stride = pages > NUMA_SAMPLES ? pages / NUMA_SAMPLES : 1;
+	size_t n = (pages + stride - 1) / stride;
+	void **addr = new void*[n];
+	int *status = new int[n];
+	for (size_t i = 0; i < n; i++)
+		addr[i] = (void *)(mem + i * stride * page);
+
+	ostringstream out;
+	if (syscall(SYS_move_pages, 0, n, addr, NULL, status, 0) != 0)
+		out<<"nodes unknown ("<<strerror(errno)<<")";
+	else {
+		int *count = new int[NUMA_MAXNODES]();
+		size_t resident = 0;
+		for (size_t i = 0; i < n; i++)
+			if (status[i] >= 0 && status[i] < NUMA_MAXNODES) {
+				count[status[i]]++;
+				resident++;
+			}
+		for (int node = 0; node < NUMA_MAXNODES; node++)
+			if (count[node] > 0)
+				out<<(out.tellp() > 0 ? ", " : "")<<"node"<<node<<" "<<100.0 * count[node] / resident<<"%";
+		if (resident == 0)
+			out<<"no resident pages";
+		delete[] count;
+	}
+	delete[] addr;
+	delete[] status;
+	return out.str();
+}
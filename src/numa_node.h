@@ -0,0 +1,37 @@
+#ifndef _NUMA_NODE_H_
+#define _NUMA_NODE_H_
+
+#include <cstddef>
+#include <string>
+
+/*
+* NUMA placement of benchmark memory without libnuma
+* nodes and their CPUs are read from /sys/devices/system/node,
+* memory is bound with the mbind system call and its placement checked with move_pages
+ */
+#define NUMA_DEFAULT -2		//kernel default policy, the main thread touches everything (default)
+#define NUMA_LOCAL -1		//first touch: every worker touches its own slice, pages land on its node
+							//node >= 0: every buffer bound to that node with mbind
+#define NUMA_INVALID -3
+
+#define NUMA_OPT 257		//getopt_long value of --numa, next to SWEEP_OPT
+#define NUMA_MATRIX_OPT 258	//getopt_long value of --numa-matrix
+
+#define NUMA_MAXNODES 1024	//size of the mbind node mask
+#define NUMA_SAMPLES 4096	//pages sampled by nodeReport
+
+typedef int NUMA_MODE;		//NUMA_DEFAULT, NUMA_LOCAL or a node id
+
+
+/*
+* functions declarations
+ */
+NUMA_MODE parseNumaMode (const char *arg);
+int readNodes (const char *list, int **nodes);
+int nodeCpus (int node, int **cpus);
+std::string nodeDistance (int node);
+bool bindToNode (char *mem, size_t bytes, int node);
+std::string nodeReport (const char *mem, size_t bytes);
+
+
+#endif
@@ -0,0 +1,166 @@
+/**
+ * @file page_alloc.cpp
+ * buffers backed by 4KB pages, transparent huge pages or explicit hugetlb pages
+ *
+ * explicit pages come from the reserved pool, for example
+ *   echo 1024 > /sys/kernel/mm/hugepages/hugepages-2048kB/nr_hugepages
+ *   echo 4 > /sys/kernel/mm/hugepages/hugepages-1048576kB/nr_hugepages
+ * THP only succeeds if /sys/kernel/mm/transparent_hugepage/enabled is "always" or "madvise"
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <cstdio>		//sscanf
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdint>
+#include <sys/mman.h>
+#include <linux/mman.h>		//MAP_HUGE_2MB, MAP_HUGE_1GB
+#include "page_alloc.h"
+
+using namespace std;
+
+
+const char* page_name[] = {"4KB", "THP (madvise)", "2MB hugetlb", "1GB hugetlb"};
+
+#define GUARD 4096L		//inaccessible page on both sides of a buffer, keeps the kernel from merging it with a neighbour mapping
+
+
+
+/**
+ * mapping length of a buffer, whole pages of the requested size
+ * @param  bytes buffer size
+ * @param  mode  page size backing
+ * @return       bytes to map
+ */
+static size_t mapLength (size_t bytes, PAGE_MODE mode) {
+	size_t page = (mode == PAGE_1G) ? HUGE_1G : (mode == PAGE_2M || mode == PAGE_THP) ? HUGE_2M : 4096;
+	return (bytes + page - 1) / page * page;
+}
+
+
+
+/**
+ * guard length on each side of a buffer, hugetlb mappings are never merged and need none
+ * @param  mode page size backing
+ * @return      bytes
+ */
+static size_t guardLength (PAGE_MODE mode) {
+	return (mode == PAGE_2M || mode == PAGE_1G) ? 0 : GUARD;
+}
+
+
+
+/**
+ * map an anonymous buffer with the requested page size, nothing is touched yet
+ * every buffer stays a mapping of its own, so its line in /proc/self/smaps describes only this buffer
+ * @param  bytes buffer size
+ * @param  mode  page size backing
+ * @return       buffer, NULL if the mapping failed (for hugetlb: the pool is too small)
+ */
+char *pageAlloc (size_t bytes, PAGE_MODE mode) {
+	size_t length = mapLength(bytes, mode);
+	size_t guard = guardLength(mode);
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	if (mode == PAGE_2M)
+		flags |= MAP_HUGETLB | MAP_HUGE_2MB;
+	else if (mode == PAGE_1G)
+		flags |= MAP_HUGETLB | MAP_HUGE_1GB;
+
+	//THP needs a 2MB aligned range: map one huge page more and trim what is left around buffer and guards
+	size_t total = guard + length + guard + (mode == PAGE_THP ? HUGE_2M : 0);
+	char *raw = (char *)mmap(NULL, total, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (raw == MAP_FAILED) {
+		if (mode == PAGE_2M || mode == PAGE_1G)
+			cerr<<"Cannot map "<<length / HUGE_2M * 2<<"MB of "<<page_name[mode]
+				<<" pages, reserve them in /sys/kernel/mm/hugepages first!"<<endl;
+		return NULL;
+	}
+	char *mem = raw + guard;
+	if (mode == PAGE_THP)
+		mem = (char *)(((uintptr_t)mem + HUGE_2M - 1) & ~(uintptr_t)(HUGE_2M - 1));
+	if (mem - guard > raw)
+		munmap(raw, mem - guard - raw);
+	if (raw + total > mem + length + guard)
+		munmap(mem + length + guard, raw + total - (mem + length + guard));
+	if (guard > 0) {
+		mprotect(mem - guard, guard, PROT_NONE);
+		mprotect(mem + length, guard, PROT_NONE);
+	}
+
+	if (mode == PAGE_4K)
+		madvise(mem, length, MADV_NOHUGEPAGE);
+	else if (mode == PAGE_THP && madvise(mem, length, MADV_HUGEPAGE) != 0)
+		cerr<<"MADV_HUGEPAGE failed, THP is disabled on this system"<<endl;
+	return mem;
+}
+
+
+
+/**
+ * unmap a buffer of pageAlloc
+ * @param mem   buffer
+ * @param bytes buffer size given to pageAlloc
+ * @param mode  page size backing given to pageAlloc
+ */
+void pageFree (char *mem, size_t bytes, PAGE_MODE mode) {
+	size_t guard = guardLength(mode);
+	if (mem != NULL)
+		munmap(mem - guard, mapLength(bytes, mode) + 2 * guard);
+}
+
+
+
+/**
+ * pages the kernel backs a buffer with, from its mapping in /proc/self/smaps
+ * only touched pages are resident, so call it after the buffer was used
+ * @param  mem buffer of pageAlloc
+ * @return     like "KernelPageSize 4 kB, Rss 1048576 kB, AnonHugePages 1046528 kB (99.8%)"
+ */
+string pageReport (const char *mem) {
+	ifstream in("/proc/self/smaps");
+	string line;
+	bool found = false;
+	long page = 0, rss = 0, thp = 0, hugetlb = 0;
+	uintptr_t addr = (uintptr_t)mem;
+	while (getline(in, line)) {
+		unsigned long start, end;
+		//a mapping header starts with "start-end", the fields of the mapping follow it
+		if (sscanf(line.c_str(), "%lx-%lx ", &start, &end) == 2 && line.find(':') > line.find(' ')) {
+			if (found)
+				break;
+			found = addr >= start && addr < end;
+			continue;
+		}
+		if (!found)
+			continue;
+		istringstream field(line);
+		string key;
+		long value;
+		field>>key>>value;
+		if (key == "KernelPageSize:")
+			page = value;
+		else if (key == "Rss:")
+			rss = value;
+		else if (key == "AnonHugePages:")
+			thp = value;
+		else if (key == "Private_Hugetlb:")
+			hugetlb = value;
+	}
+	if (!found)
+		return "unknown (no mapping in /proc/self/smaps)";
+
+	ostringstream out;
+	out<<"KernelPageSize "<<page<<" kB";
+	if (hugetlb > 0)
+		out<<", Hugetlb "<<hugetlb<<" kB";
+	else {
+		out<<", Rss "<<rss<<" kB, AnonHugePages "<<thp<<" kB";
+		if (rss > 0)
+			out<<" ("<<100.0 * thp / rss<<"%)";
+	}
+	return out.str();
+}
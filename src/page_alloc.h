@@ -0,0 +1,34 @@
+#ifndef _PAGE_ALLOC_H_
+#define _PAGE_ALLOC_H_
+
+#include <cstddef>
+#include <string>
+
+/*
+* page size backing of benchmark buffers
+* every buffer is its own anonymous mapping, so /proc/self/smaps shows what the kernel actually gave it
+ */
+#define PAGE_SYSTEM -1	//whatever the THP policy of the system gives (default)
+#define PAGE_4K 0		//4KB pages, THP disabled on the buffer with MADV_NOHUGEPAGE
+#define PAGE_THP 1		//transparent huge pages requested with MADV_HUGEPAGE, 2MB aligned
+#define PAGE_2M 2		//explicit 2MB pages from the hugetlb pool, MAP_HUGETLB
+#define PAGE_1G 3		//explicit 1GB pages from the hugetlb pool, MAP_HUGETLB
+#define NUM_PAGE 4
+
+#define HUGE_2M (2L << 20)
+#define HUGE_1G (1L << 30)
+
+typedef int PAGE_MODE;		//page size backing
+
+extern const char* page_name[];
+
+
+/*
+* functions declarations
+ */
+char *pageAlloc (size_t bytes, PAGE_MODE mode);
+void pageFree (char *mem, size_t bytes, PAGE_MODE mode);
+std::string pageReport (const char *mem);
+
+
+#endif
@@ -4,9 +4,10 @@
 #
 
 cpu=./cpu 
-cpuavx=./cpuavx
 gpu=./gpu 
 memory=./memory
+contention=./contention
+allocator=./allocator
 disk=./disk
 network=./network
 
@@ -15,32 +16,18 @@ ignore=false
 echo " start all benchmarks in default settings.."
 
 echo " benchmark CPU.."
+#every ISA level supported by the host (Scalar, SSE2, AVX, AVX2+FMA, AVX-512) is covered by each run
+#--sweep-threads steps 1, 2, 4, ... up to every online CPU in one process and reports the scaling
 
 for opt in 0 1
 do
-	for thread in 1 2 4 8
-	do
-		$cpu -o$opt -t$thread
-	done
+	$cpu -o$opt --sweep-threads
 	echo ""
 done
 
 echo " CPU done.."
 
 
-echo " benchmark CPU with AVX.."
-for opt in 0 1
-do
-	for thread in 1 2 4 8
-	do
-		$cpuavx -o$opt -t$thread
-	done
-	echo " "
-done
-
-echo " CPU AVX done.."
-
-
 
 # echo " benchmark GPU.."
 
@@ -51,13 +38,9 @@ echo " CPU AVX done.."
 	
 # for opt in 0 1 2
 # do
-# 	for thread in 1 2 4 8
-# 	do 
-# 		for blocksize in 8B 8KB 8MB 80MB
-# 		do
-# 			$memory -o$opt -t$thread -b$blocksize
-# 		done
-# 		echo " "
+# 	for blocksize in 8B 8KB 8MB 80MB
+# 	do
+# 		$memory -o$opt -b$blocksize --sweep-threads
 # 	done
 # 	echo " "
 # done
@@ -65,21 +48,32 @@ echo " CPU AVX done.."
 # echo " memory done.."
 
 
+echo " benchmark contention.."
+#fetch_add, CAS and exchange on a shared line, padded lines and falsely shared lines
+$contention --sweep-threads
+echo " contention done.."
+
+
+echo " benchmark allocator.."
+#malloc, new, arena and pool on mixed sizes, each thread freeing its own blocks, then producer/consumer
+for pattern in 0 1
+do
+	$allocator -x$pattern --sweep-threads
+done
+echo " allocator done.."
+
+
 echo " benchmark disk.."
 for opt in 0 1 2
 do
-	for thread in 1 2 4 8
+	for blocksize in 8B 8KB 8MB 80MB
 	do
-		for blocksize in 8B 8KB 8MB 80MB
-		do
-			if $ignore; then
-				$disk -i -o$opt -t$thread -b$blocksize
-			else
-				$disk -o$opt -t$thread -b$blocksize
-				let $ignore=true
-			fi
-		done
-		echo " "
+		if $ignore; then
+			$disk -i -o$opt -b$blocksize --sweep-threads
+		else
+			$disk -o$opt -b$blocksize --sweep-threads
+			let $ignore=true
+		fi
 	done
 	echo " "
 done
@@ -0,0 +1,98 @@
+/**
+ * @file scaling.cpp
+ * thread-scaling sweep: thread counts to step through and the scaling report
+ *
+ * speedup S(p) = rate(p) / rate(1), parallel efficiency E(p) = S(p) / p
+ * the serial fraction f comes from a least-squares fit of Amdahl's law
+ *   1/S = f + (1 - f)/p,  i.e. y - x = f (1 - x) with y = 1/S and x = 1/p
+ *   f = sum((y - x)(1 - x)) / sum((1 - x)^2)
+ * the per-point Karp-Flatt metric (1/S - 1/p) / (1 - 1/p) is the same estimate from a single point,
+ * a value growing with p points at overhead (contention, bandwidth) rather than serial code
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <iostream>
+#include <cstring>
+#include "scaling.h"
+
+using namespace std;
+
+
+const char* sweep_name[] = {"none", "linear", "powers of two"};
+
+
+
+/**
+ * parse the argument of --sweep-threads
+ * @param  arg "linear", "pow2", or NULL when the option has no argument
+ * @return     sweep mode, -1 if the argument is invalid
+ */
+SWEEP parseSweepMode (const char *arg) {
+	if (arg == NULL || strcmp(arg, "pow2") == 0)
+		return SWEEP_POW2;
+	if (strcmp(arg, "linear") == 0)
+		return SWEEP_LINEAR;
+	return -1;
+}
+
+
+
+/**
+ * thread counts of a sweep, always starting at 1 and ending at max_threads
+ * @param  mode        SWEEP_LINEAR or SWEEP_POW2
+ * @param  max_threads largest thread count
+ * @param  counts      output array, allocated with new[]
+ * @return             number of steps
+ */
+int sweepThreadCounts (SWEEP mode, int max_threads, int **counts) {
+	*counts = new int[max_threads];
+	int n = 0;
+	if (mode == SWEEP_LINEAR) {
+		for (int p = 1; p <= max_threads; p++)
+			(*counts)[n++] = p;
+	} else {
+		for (int p = 1; p < max_threads; p *= 2)
+			(*counts)[n++] = p;
+		(*counts)[n++] = max_threads;		//N itself, also when it is not a power of two
+	}
+	return n;
+}
+
+
+
+/**
+ * print speedup, parallel efficiency and the fitted serial fraction of a sweep
+ * @param threads thread count of each step, threads[0] = 1
+ * @param rate    aggregate rate of each step, best of the repeats
+ * @param n       number of steps
+ * @param unit    rate unit, like "MB/s"
+ */
+void printScalingReport (const int *threads, const double *rate, int n, const char *unit) {
+	cout<<endl<<"Thread scaling (fixed total work):"<<endl;
+	cout<<"#Thread\tRate("<<unit<<")\tSpeedup\tEfficiency\tKarp-Flatt"<<endl;
+
+	double num = 0, den = 0;	//least-squares sums of the Amdahl fit
+	for (int i = 0; i < n; i++) {
+		double speedup = rate[i] / rate[0];
+		double x = 1.0 / threads[i], y = 1.0 / speedup;
+		cout<<threads[i]<<"\t"<<rate[i]<<"\t"<<speedup<<"\t"<<speedup / threads[i] * 100<<"%\t";
+		if (threads[i] > 1)
+			cout<<(y - x) / (1 - x)<<endl;
+		else
+			cout<<"-"<<endl;
+		num += (y - x) * (1 - x);
+		den += (1 - x) * (1 - x);
+	}
+
+	if (den == 0) {
+		cout<<"Serial fraction:\tn/a (needs more than one thread count)"<<endl;
+		return;
+	}
+	double f = num / den;
+	cout<<"Serial fraction (Amdahl fit):\t"<<f * 100<<"%";
+	if (f > 0)
+		cout<<"\tspeedup limit 1/f = "<<1 / f;
+	cout<<endl;
+}
@@ -0,0 +1,28 @@
+#ifndef _SCALING_H_
+#define _SCALING_H_
+
+/*
+* thread-scaling sweep shared by all benchmarks
+* the total work stays fixed while the thread count steps from 1 to N in one process (strong scaling)
+ */
+
+#define SWEEP_NONE 0	//single run with the given thread count (default)
+#define SWEEP_LINEAR 1	//1, 2, 3, ..., N
+#define SWEEP_POW2 2	//1, 2, 4, ..., N
+
+#define SWEEP_OPT 256	//getopt_long value of --sweep-threads, outside the range of short options
+
+typedef int SWEEP;		//sweep mode
+
+extern const char* sweep_name[];
+
+
+/*
+* functions declarations
+ */
+SWEEP parseSweepMode (const char *arg);
+int sweepThreadCounts (SWEEP mode, int max_threads, int **counts);
+void printScalingReport (const int *threads, const double *rate, int n, const char *unit);
+
+
+#endif
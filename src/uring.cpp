@@ -0,0 +1,235 @@
+/**
+ * @file uring.cpp
+ * io_uring set up and driven with the raw system calls
+ *
+ * a request is prepared in a submission queue entry, many of them go to the kernel in one io_uring_enter,
+ * and their results come back in the completion queue, in any order, tagged with the user data of the request
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>		//iovec
+#include "uring.h"
+
+
+
+/**
+ * wrappers of the three io_uring system calls, glibc has none
+ */
+static int sysSetup (unsigned entries, struct io_uring_params *p) {
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sysEnter (int fd, unsigned submit, unsigned wait, unsigned flags) {
+	return (int)syscall(__NR_io_uring_enter, fd, submit, wait, flags, NULL, 0);
+}
+
+static int sysRegister (int fd, unsigned opcode, const void *arg, unsigned n) {
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, n);
+}
+
+
+
+/**
+ * create a ring and map its submission queue, completion queue and entries
+ * @param  r       ring to set up
+ * @param  entries submission queue size, the kernel rounds it up to a power of two
+ * @return         false if io_uring is not available (old kernel, seccomp, io_uring_disabled)
+ */
+bool uringInit (uring *r, unsigned entries) {
+	memset(r, 0, sizeof(uring));
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	if ((r->fd = sysSetup(entries, &p)) < 0) {
+		r->fd = -1;
+		return false;
+	}
+	r->entries = p.sq_entries;
+
+	r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->sq_len = r->cq_len = (r->sq_len > r->cq_len ? r->sq_len : r->cq_len);
+
+	r->sq_ring = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_ring == MAP_FAILED) {
+		close(r->fd);
+		r->fd = -1;
+		return false;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->cq_ring = r->sq_ring;
+	else if ((r->cq_ring = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING)) == MAP_FAILED) {
+		munmap(r->sq_ring, r->sq_len);
+		close(r->fd);
+		r->fd = -1;
+		return false;
+	}
+	r->sqes = (struct io_uring_sqe *)mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED) {
+		if (r->cq_ring != r->sq_ring)
+			munmap(r->cq_ring, r->cq_len);
+		munmap(r->sq_ring, r->sq_len);
+		close(r->fd);
+		r->fd = -1;
+		return false;
+	}
+
+	char *sq = (char *)r->sq_ring, *cq = (char *)r->cq_ring;
+	r->sq_head = (unsigned *)(sq + p.sq_off.head);
+	r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+	r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+	r->sq_array = (unsigned *)(sq + p.sq_off.array);
+	r->cq_head = (unsigned *)(cq + p.cq_off.head);
+	r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+	r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+	r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+	return true;
+}
+
+
+
+/**
+ * unmap and close a ring, registered buffers and files go with it
+ * @param r ring, may be one that failed to set up
+ */
+void uringExit (uring *r) {
+	if (r->fd < 0)
+		return;
+	munmap(r->sqes, r->entries * sizeof(struct io_uring_sqe));
+	if (r->cq_ring != r->sq_ring)
+		munmap(r->cq_ring, r->cq_len);
+	munmap(r->sq_ring, r->sq_len);
+	close(r->fd);
+	r->fd = -1;
+}
+
+
+
+/**
+ * register buffers, the kernel pins and maps them once instead of on every request
+ * pinned memory counts against RLIMIT_MEMLOCK on older kernels, so this may fail where plain requests work
+ * @param  r    ring
+ * @param  bufs buffers, a request names one by its index
+ * @param  n    number of buffers (<= URING_MAXDEPTH)
+ * @param  len  bytes of every buffer
+ * @return      true if the requests can use READ_FIXED/WRITE_FIXED
+ */
+bool uringRegisterBuffers (uring *r, char **bufs, int n, size_t len) {
+	struct iovec iov[URING_MAXDEPTH];
+	for (int i = 0; i < n; i++) {
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len = len;
+	}
+	r->fixed_bufs = (sysRegister(r->fd, IORING_REGISTER_BUFFERS, iov, n) == 0);
+	return r->fixed_bufs;
+}
+
+
+
+/**
+ * register files, which saves the descriptor lookup and reference count of every request
+ * @param  r   ring
+ * @param  fds descriptors, must stay valid while the ring is used: requests fall back to them if registration fails
+ * @param  n   number of descriptors
+ * @return     true if the requests use fixed files
+ */
+bool uringRegisterFiles (uring *r, const int *fds, int n) {
+	r->files = fds;
+	r->fixed_files = (sysRegister(r->fd, IORING_REGISTER_FILES, fds, n) == 0);
+	return r->fixed_files;
+}
+
+
+
+/**
+ * prepare a read or write in the next free submission queue entry, submitted by the next uringSubmit
+ * the caller keeps at most r->entries requests queued or in flight
+ * @param r         ring
+ * @param write     write if true, read otherwise
+ * @param file      index of the file in the files given to uringRegisterFiles
+ * @param buf       buffer
+ * @param buf_index index of the buffer in the registered buffers, ignored without fixed buffers
+ * @param len       bytes
+ * @param offset    file offset
+ * @param data      user data, comes back with the completion
+ */
+void uringPrep (uring *r, bool write, int file, char *buf, int buf_index, size_t len, off_t offset, uint64_t data) {
+	unsigned tail = *r->sq_tail + r->queued;
+	unsigned index = tail & *r->sq_mask;
+	struct io_uring_sqe *sqe = &r->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	if (r->fixed_bufs) {
+		sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+		sqe->buf_index = buf_index;
+	} else
+		sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+	if (r->fixed_files) {
+		sqe->fd = file;
+		sqe->flags = IOSQE_FIXED_FILE;
+	} else
+		sqe->fd = r->files[file];
+	sqe->addr = (uint64_t)(uintptr_t)buf;
+	sqe->len = len;
+	sqe->off = offset;
+	sqe->user_data = data;
+	r->sq_array[index] = index;
+	r->queued++;
+}
+
+
+
+/**
+ * hand every prepared request to the kernel, and wait for completions
+ * the kernel may take fewer entries than offered (the rest stay in the submission queue, between its head and our tail),
+ * or refuse the call for a moment with EAGAIN (no memory for requests) or EBUSY (completion queue backlog),
+ * so the call is repeated until every published entry is consumed
+ * @param  r    ring
+ * @param  wait completions to wait for, 0 to return right after submitting
+ * @return      requests submitted, -errno on failure
+ */
+int uringSubmit (uring *r, unsigned wait) {
+	unsigned tail = *r->sq_tail + r->queued;
+	__atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE);		//entries visible before the new tail
+	r->queued = 0;
+	int total = 0;
+	for (;;) {
+		unsigned pending = tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);		//published, not yet consumed
+		int ret = sysEnter(r->fd, pending, wait, wait > 0 ? IORING_ENTER_GETEVENTS : 0);
+		if (ret < 0) {
+			if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+				continue;
+			return -errno;
+		}
+		total += ret;
+		if ((unsigned)ret >= pending)
+			return total;
+	}
+}
+
+
+
+/**
+ * take the next completion off the completion queue, without a system call
+ * @param  r    ring
+ * @param  data user data of the completed request
+ * @param  res  bytes transferred, -errno on failure
+ * @return      false if the queue is empty
+ */
+bool uringReap (uring *r, uint64_t *data, int *res) {
+	unsigned head = *r->cq_head;
+	if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE))
+		return false;
+	struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+	*data = cqe->user_data;
+	*res = cqe->res;
+	__atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);		//slot free for the kernel again
+	return true;
+}
@@ -0,0 +1,47 @@
+#ifndef _URING_H_
+#define _URING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <linux/io_uring.h>
+
+/*
+* minimal io_uring on the raw system calls, liburing is not needed
+* one ring per thread, no locking: a ring is only touched by the thread that owns it
+* buffers and files are registered with the kernel if it allows it (fixed buffers and files),
+* otherwise plain read/write requests on the same buffers and descriptors are used
+ */
+
+#define URING_MAXDEPTH 1024		//largest queue depth, also the buffer count a ring can register
+
+
+typedef struct {
+	int fd;		//ring descriptor, -1 if not set up
+	unsigned entries;		//submission queue size
+	unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+	struct io_uring_sqe *sqes;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_cqe *cqes;
+	void *sq_ring, *cq_ring;		//mappings, cq_ring == sq_ring with IORING_FEAT_SINGLE_MMAP
+	size_t sq_len, cq_len;
+	unsigned queued;		//prepared requests not yet submitted
+	const int *files;		//descriptors, a request names a file by its index in here
+	bool fixed_files;		//files registered, requests carry IOSQE_FIXED_FILE
+	bool fixed_bufs;		//buffers registered, requests are READ_FIXED/WRITE_FIXED
+} uring;
+
+
+/*
+* functions declarations
+ */
+bool uringInit (uring *r, unsigned entries);
+void uringExit (uring *r);
+bool uringRegisterBuffers (uring *r, char **bufs, int n, size_t len);
+bool uringRegisterFiles (uring *r, const int *fds, int n);
+void uringPrep (uring *r, bool write, int file, char *buf, int buf_index, size_t len, off_t offset, uint64_t data);
+int uringSubmit (uring *r, unsigned wait);
+bool uringReap (uring *r, uint64_t *data, int *res);
+
+
+#endif
@@ -0,0 +1,248 @@
+/**
+ * @file worker_pool.cpp
+ * persistent worker pool with a barrier-synchronised start
+ *
+ * each run has two phases:
+ *   arm:     idle workers are woken through a futex and spin at the barrier
+ *   release: once every worker is spinning, the clock starts and the barrier opens
+ * the last worker to finish stops the clock, so only the job itself is timed
+ * every worker also stamps its own start and end, which exposes imbalance between threads
+ * all clocks are CLOCK_MONOTONIC_RAW, not affected by NTP slewing or wall clock jumps
+ *
+ * author: Linlin Chen
+ * lchen96@hawk.iit.edu
+ */
+
+#include <cstdlib>
+#include <climits>
+#include <iostream>
+#include <atomic>
+#include <ctime>
+#include <algorithm>	//std::sort
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "affinity.h"
+#include "worker_pool.h"
+
+using namespace std;
+
+
+#define SPIN_YIELD 1024		//spins at the barrier between two sched_yield, lets oversubscribed workers progress
+
+
+static int pool_size = 0;
+static pthread_t *workers;
+static int *workerID;
+
+static atomic<int> arm(0);			//futex word, bumped to wake idle workers for a new job
+static int armBase = 0;				//arm when the pool was created, a new worker has seen every earlier job
+static atomic<int> go(0);			//bumped to open the barrier
+static atomic<int> arrived(0);		//workers spinning at the barrier
+static atomic<int> remaining(0);	//workers still running the job
+static atomic<int> done(0);			//futex word, bumped by the last worker
+static bool quit = false;
+static pool_func job;
+static struct timespec starttime, endtime;
+static struct timespec *threadStart, *threadEnd;	//per worker
+static thread_time *threadTimes;
+
+
+
+/**
+ * block while *word == value
+ */
+static void futexWait (atomic<int> *word, int value) {
+	syscall(SYS_futex, (int *)word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+/**
+ * wake every thread blocked on word
+ */
+static void futexWake (atomic<int> *word) {
+	syscall(SYS_futex, (int *)word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+
+
+/**
+ * seconds from a to b
+ */
+static double elapsed (const struct timespec &a, const struct timespec &b) {
+	return (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+
+
+/**
+ * worker loop: sleep until armed, spin at the barrier, run the job, report completion
+ * @param  argv worker ID
+ * @return      NULL once the pool is destroyed
+ */
+static void *workerLoop (void *argv) {
+	int seen = armBase;
+	for (;;) {
+		int a;
+		while ((a = arm.load()) == seen)
+			futexWait(&arm, seen);
+		seen = a;
+		if (quit)
+			break;
+
+		int gen = go.load();
+		arrived.fetch_add(1);
+		for (long spins = 1; go.load() == gen; spins++) {
+			__builtin_ia32_pause();
+			if (spins % SPIN_YIELD == 0)
+				sched_yield();
+		}
+
+		int id = *(int *)argv;
+		clock_gettime(CLOCK_MONOTONIC_RAW, &threadStart[id]);
+		job(argv);
+		clock_gettime(CLOCK_MONOTONIC_RAW, &threadEnd[id]);
+
+		if (remaining.fetch_sub(1) == 1) {
+			endtime = threadEnd[id];
+			done.fetch_add(1);
+			futexWake(&done);
+		}
+	}
+	return NULL;
+}
+
+
+
+/**
+ * create the workers, once per process
+ * @param thread_num number of workers
+ * @param cpus       CPU id per worker, NULL leaves them unpinned
+ */
+void poolCreate (int thread_num, const int *cpus) {
+	pool_size = thread_num;
+	armBase = arm.load();		//poolDestroy of an earlier pool bumped arm, that is no job
+	workers = new pthread_t[thread_num];
+	workerID = new int[thread_num];
+	threadStart = new struct timespec[thread_num];
+	threadEnd = new struct timespec[thread_num];
+	threadTimes = new thread_time[thread_num];
+	for (int i = 0; i < thread_num; i++) {
+		workerID[i] = i;
+		if (createThread(&workers[i], cpus ? cpus[i] : -1, workerLoop, (void *)(workerID + i)) != 0) {
+			cerr<<"Cannot create worker thread "<<i<<endl;
+			exit(2);
+		}
+	}
+}
+
+
+
+/**
+ * run one job on every worker
+ * @param  func thread function, called with a pointer to the worker ID
+ * @return      seconds from barrier release to the last worker finishing
+ */
+double poolRun (pool_func func) {
+	job = func;
+	arrived.store(0);
+	remaining.store(pool_size);
+	int d = done.load();
+
+	//arm: wake the workers and wait until all of them spin at the barrier
+	arm.fetch_add(1);
+	futexWake(&arm);
+	while (arrived.load() < pool_size)
+		sched_yield();
+
+	//release
+	clock_gettime(CLOCK_MONOTONIC_RAW, &starttime);
+	go.fetch_add(1);
+
+	while (done.load() == d)
+		futexWait(&done, d);
+
+	for (int i = 0; i < pool_size; i++) {
+		threadTimes[i].start = elapsed(starttime, threadStart[i]);
+		threadTimes[i].end = elapsed(starttime, threadEnd[i]);
+	}
+	return elapsed(starttime, endtime);
+}
+
+
+
+/**
+ * stop and join the workers
+ */
+void poolDestroy () {
+	quit = true;
+	arm.fetch_add(1);
+	futexWake(&arm);
+	for (int i = 0; i < pool_size; i++)
+		pthread_join(workers[i], NULL);
+	delete[] workers;
+	delete[] workerID;
+	delete[] threadStart;
+	delete[] threadEnd;
+	delete[] threadTimes;
+	pool_size = 0;
+	quit = false;
+}
+
+
+
+/**
+ * per-worker timing of the last run
+ * @return array of pool size entries
+ */
+const thread_time *poolThreadTimes () {
+	return threadTimes;
+}
+
+
+
+/**
+ * print per-thread throughput of the last run, the aggregate as a sum of rates,
+ * and the skew between threads
+ * low skew with a low aggregate points at a saturated shared resource,
+ * high skew points at slow cores or uneven work
+ * @param work  amount of work done by each worker, in units of "unit" x seconds
+ * @param unit  rate unit, like "MB/s"
+ * @param cpus  CPU each worker ran on, NULL if unknown
+ */
+void printThreadReport (const double *work, const char *unit, const int *cpus) {
+	double *duration = new double[pool_size];
+	double aggregate = 0, mean = 0;
+	double fastest = 0, slowest = 0;
+	for (int i = 0; i < pool_size; i++) {
+		duration[i] = threadTimes[i].end - threadTimes[i].start;
+		aggregate += work[i] / duration[i];
+		mean += duration[i];
+		if (i == 0 || duration[i] < fastest)
+			fastest = duration[i];
+		if (i == 0 || duration[i] > slowest)
+			slowest = duration[i];
+	}
+	mean /= pool_size;
+
+	double *sorted = new double[pool_size];
+	copy(duration, duration + pool_size, sorted);
+	sort(sorted, sorted + pool_size);
+	double median = sorted[pool_size / 2];
+
+	int stragglers = 0;
+	for (int i = 0; i < pool_size; i++) {
+		bool slow = duration[i] > median * (1 + STRAGGLER_THRESHOLD);
+		stragglers += slow;
+		cout<<"\tThread "<<i<<"\tCPU "<<(cpus ? cpus[i] : -1)
+			<<"\tstart "<<threadTimes[i].start * 1e6<<"us\t"<<duration[i]<<"s\t"
+			<<work[i] / duration[i]<<unit<<(slow ? "\tSTRAGGLER" : "")<<endl;
+	}
+	cout<<"\tAggregate (sum of rates)\t"<<aggregate<<unit
+		<<"\tSkew "<<(slowest - fastest) / mean * 100<<"% (max-min)/mean"
+		<<"\t"<<stragglers<<" straggler(s)"<<endl;
+
+	delete[] sorted;
+	delete[] duration;
+}
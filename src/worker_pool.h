@@ -0,0 +1,35 @@
+#ifndef _WORKER_POOL_H_
+#define _WORKER_POOL_H_
+
+/*
+* persistent worker pool shared by all benchmarks
+* workers are created (and pinned) once per process and reused by every repeat,
+* so thread creation and teardown stay outside the timed region
+ */
+
+#define STRAGGLER_THRESHOLD 0.10		//a worker slower than the median by more than 10% is a straggler
+
+typedef void *(*pool_func)(void *);	//thread function, receives a pointer to the worker's thread ID
+
+
+/*
+* per-worker timing of the last run, CLOCK_MONOTONIC_RAW
+* in seconds relative to the barrier release
+ */
+typedef struct {
+	double start;
+	double end;
+} thread_time;
+
+
+/*
+* functions declarations
+ */
+void poolCreate (int thread_num, const int *cpus);
+double poolRun (pool_func func);
+void poolDestroy ();
+const thread_time *poolThreadTimes ();
+void printThreadReport (const double *work, const char *unit, const int *cpus);
+
+
+#endif